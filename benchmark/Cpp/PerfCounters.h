@@ -0,0 +1,209 @@
+/*******************************************************************************
+ This file is part of FeCl.
+ 
+ Copyright (c) 2015, Etienne Pierre-Doray, INRS
+ Copyright (c) 2015, Leszek Szczecinski, INRS
+ All rights reserved.
+ 
+ FeCl is free software: you can redistribute it and/or modify
+ it under the terms of the Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ FeCl is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the Lesser General Public License
+ along with FeCl.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#ifndef FEC_BENCHMARK_PERF_COUNTERS_H
+#define FEC_BENCHMARK_PERF_COUNTERS_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <boost/property_tree/ptree.hpp>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ *  This class collects hardware performance counters of the process around timed regions.
+ *  Counters are opened with perf_event_open and follow the threads created while they are enabled.
+ *  Counters which cannot be opened, for instance in a container or on another platform,
+ *  are reported as unavailable and left out of the results.
+ *  There is no portable event for vector instructions,
+ *  so its raw event code is read from the FECL_PERF_VECTOR_EVENT environment variable.
+ */
+class PerfCounters {
+public:
+  enum Event {
+    Cycles,
+    Instructions,
+    L1Misses,
+    LlcMisses,
+    BranchMisses,
+    VectorInstructions,
+    EventCount,
+  };
+  
+  PerfCounters() {
+    for (size_t i = 0; i < EventCount; ++i) {
+      fd_[i] = -1;
+      count_[i] = 0.0;
+    }
+#if defined(__linux__)
+    open(Cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    open(Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    open(L1Misses, PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    open(LlcMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    open(BranchMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    const char* vectorEvent = std::getenv("FECL_PERF_VECTOR_EVENT");
+    if (vectorEvent != nullptr) {
+      open(VectorInstructions, PERF_TYPE_RAW, std::strtoull(vectorEvent, nullptr, 0));
+    }
+#endif
+  }
+  ~PerfCounters() {
+#if defined(__linux__)
+    for (size_t i = 0; i < EventCount; ++i) {
+      if (fd_[i] != -1) {
+        close(fd_[i]);
+      }
+    }
+#endif
+  }
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+  
+  bool isAvailable(Event event) const {return fd_[event] != -1;} /**< Access wether an event is counted. */
+  bool isAvailable() const {
+    for (size_t i = 0; i < EventCount; ++i) {
+      if (isAvailable(Event(i))) {
+        return true;
+      }
+    }
+    return false;
+  }
+  double count(Event event) const {return count_[event];} /**< Access the count accumulated over the regions. */
+  size_t regionCount() const {return regionCount_;} /**< Access the number of regions measured. */
+  
+  static const char* name(Event event) {
+    const char* names[] = {"cycles", "instructions", "l1Misses", "llcMisses", "branchMisses", "vectorInstructions"};
+    return names[event];
+  }
+  
+  /**
+   *  Clears the accumulated counts.
+   */
+  void clear() {
+    for (size_t i = 0; i < EventCount; ++i) {
+      count_[i] = 0.0;
+    }
+    regionCount_ = 0;
+  }
+  
+  /**
+   *  Starts counting a region.
+   */
+  void start() {
+#if defined(__linux__)
+    for (size_t i = 0; i < EventCount; ++i) {
+      if (fd_[i] != -1) {
+        ioctl(fd_[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd_[i], PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+#endif
+  }
+  
+  /**
+   *  Stops counting a region and accumulates its counts.
+   *  Counts are scaled when the kernel multiplexed the counters.
+   */
+  void stop() {
+#if defined(__linux__)
+    for (size_t i = 0; i < EventCount; ++i) {
+      if (fd_[i] != -1) {
+        ioctl(fd_[i], PERF_EVENT_IOC_DISABLE, 0);
+      }
+    }
+    for (size_t i = 0; i < EventCount; ++i) {
+      uint64_t value[3];
+      if (fd_[i] != -1 && read(fd_[i], value, sizeof(value)) == sizeof(value) && value[2] > 0) {
+        count_[i] += double(value[0]) * double(value[1]) / double(value[2]);
+      }
+    }
+#endif
+    ++regionCount_;
+  }
+  
+  /**
+   *  Summarizes the counts as averages per region, with derived metrics.
+   *  \param  bitCount  Number of msg bits processed in each region
+   *  \param  iterations  Number of decoder iterations, or 1 for non-iterative operations
+   *  \param  edgeCount Number of edges processed by each iteration on all blocks of a region, or 0 if not applicable
+   */
+  boost::property_tree::ptree results(double bitCount, double iterations = 1.0, double edgeCount = 0.0) const {
+    boost::property_tree::ptree results;
+    if (regionCount_ == 0) {
+      return results;
+    }
+    for (size_t i = 0; i < EventCount; ++i) {
+      if (isAvailable(Event(i))) {
+        results.put(name(Event(i)), count_[i] / regionCount_);
+      }
+    }
+    if (isAvailable(Cycles) && isAvailable(Instructions) && count_[Cycles] > 0.0) {
+      results.put("ipc", count_[Instructions] / count_[Cycles]);
+    }
+    if (isAvailable(Cycles) && bitCount > 0.0) {
+      results.put("cyclesPerBit", count_[Cycles] / regionCount_ / bitCount);
+      results.put("cyclesPerBitIteration", count_[Cycles] / regionCount_ / bitCount / iterations);
+    }
+    if (edgeCount > 0.0) {
+      double edges = edgeCount * iterations * regionCount_;
+      if (isAvailable(L1Misses)) {
+        results.put("l1MissesPerEdge", count_[L1Misses] / edges);
+      }
+      if (isAvailable(LlcMisses)) {
+        results.put("llcMissesPerEdge", count_[LlcMisses] / edges);
+      }
+    }
+    return results;
+  }
+
+private:
+#if defined(__linux__)
+  void open(Event event, uint32_t type, uint64_t config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    fd_[event] = int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+    if (fd_[event] < 0) {
+      fd_[event] = -1;
+    }
+  }
+#endif
+  
+  int fd_[EventCount];
+  double count_[EventCount];
+  size_t regionCount_ = 0;
+};
+
+#endif
@@ -45,6 +45,8 @@ using namespace boost::property_tree;
 const size_t T = 32400;
 const size_t N = 128;
 
+std::unique_ptr<PerfCounters> counters;
+
 ptree speed_Convolutional(std::vector<double> snrdb)
 {
   ptree results;
@@ -92,19 +94,19 @@ ptree speed_Convolutional(std::vector<double> snrdb)
   }
   
   codecs[0].setWorkGroupSize(1);
-  encResults.put_child("fecl1", fecEncode(codecs[0], msg));
+  encResults.put_child("fecl1", fecEncode(codecs[0], msg, counters.get()));
   codecs[0].setWorkGroupSize(4);
-  encResults.put_child("fecl4", fecEncode(codecs[0], msg));
+  encResults.put_child("fecl4", fecEncode(codecs[0], msg, counters.get()));
   encResults.put_child("itpp", itppEncode(itppCodecs[0], itppMsg));
   
   ptree snr; for(auto it = snrdb.begin(); it != snrdb.end(); ++it) {ptree el; el.put_value(*it); snr.push_back(std::make_pair("", el));}
   
   codecs[0].setWorkGroupSize(1);
-  decResults.put_child("fecl1", fecDecode(codecs[0], msg, llr));
+  decResults.put_child("fecl1", fecDecode(codecs[0], msg, llr, counters.get()));
   decResults.put_child("fecl1.snr", snr);
   decResults.put_child("fecl1.snr", snr);
   codecs[0].setWorkGroupSize(4);
-  decResults.put_child("fecl4", fecDecode(codecs[0], msg, llr));
+  decResults.put_child("fecl4", fecDecode(codecs[0], msg, llr, counters.get()));
   decResults.put_child("fecl4.snr", snr);
   
   decResults.put_child("itpp", itppDecode(itppCodecs[0],itppMsg,itppLlr));
@@ -179,9 +181,9 @@ ptree speed_Turbo(std::vector<double> snrdb)
   }
   
   codecs[0].setWorkGroupSize(1);
-  encResults.put_child("fecl1", fecEncode(codecs[0], msg));
+  encResults.put_child("fecl1", fecEncode(codecs[0], msg, counters.get()));
   codecs[0].setWorkGroupSize(4);
-  encResults.put_child("fecl4", fecEncode(codecs[0], msg));
+  encResults.put_child("fecl4", fecEncode(codecs[0], msg, counters.get()));
   encResults.put_child("itpp", itppEncode(itppCodecs[0], itppMsg));
   
   boost::property_tree::ptree snr; for(auto it = snrdb.begin(); it != snrdb.end(); ++it) {ptree el; el.put_value(*it); snr.push_back(std::make_pair("", el));}
@@ -189,10 +191,10 @@ ptree speed_Turbo(std::vector<double> snrdb)
   std::vector<std::string> config = {"Exact", "Table", "Approximate"};
   for (int i = 0; i < codecs.size(); ++i) {
     codecs[i].setWorkGroupSize(1);
-    decResults.put_child(config[i] + ".fecl1", fecDecode(codecs[i], msg, llr));
+    decResults.put_child(config[i] + ".fecl1", fecDecode(codecs[i], msg, llr, counters.get(), 4));
     decResults.put_child(config[i] + ".fecl1.snr", snr);
     codecs[i].setWorkGroupSize(4);
-    decResults.put_child(config[i] + ".fecl4", fecDecode(codecs[i], msg, llr));
+    decResults.put_child(config[i] + ".fecl4", fecDecode(codecs[i], msg, llr, counters.get(), 4));
     decResults.put_child(config[i] + ".fecl4.snr", snr);
   }
 
@@ -263,19 +265,19 @@ ptree speed_Ldpc(std::vector<double> snrdb)
   }
   
   codecs[0].setWorkGroupSize(1);
-  encResults.put_child("fecl1", fecEncode(codecs[0], msg));
+  encResults.put_child("fecl1", fecEncode(codecs[0], msg, counters.get()));
   codecs[0].setWorkGroupSize(4);
-  encResults.put_child("fecl4", fecEncode(codecs[0], msg));
+  encResults.put_child("fecl4", fecEncode(codecs[0], msg, counters.get()));
   
   boost::property_tree::ptree snr; for(auto it = snrdb.begin(); it != snrdb.end(); ++it) {ptree el; el.put_value(*it); snr.push_back(std::make_pair("", el));}
   
   std::vector<std::string> config = {"Exact", "Table", "Approximate"};
   for (int i = 0; i < codecs.size(); ++i) {
     codecs[i].setWorkGroupSize(1);
-    decResults.put_child(config[i] + ".fecl1", fecDecode(codecs[i], msg, llr));
+    decResults.put_child(config[i] + ".fecl1", fecDecode(codecs[i], msg, llr, counters.get(), 20, double(checkMatrix.size())));
     decResults.put_child(config[i] + ".fecl1.snr", snr);
     codecs[i].setWorkGroupSize(4);
-    decResults.put_child(config[i] + ".fecl4", fecDecode(codecs[i], msg, llr));
+    decResults.put_child(config[i] + ".fecl4", fecDecode(codecs[i], msg, llr, counters.get(), 20, double(checkMatrix.size())));
     decResults.put_child(config[i] + ".fecl4.snr", snr);
   }
   
@@ -292,6 +294,15 @@ ptree speed_Ldpc(std::vector<double> snrdb)
 
 
 int main(int argc, const char * argv[]) {
+  for (int i = 1; i < argc; ++i) {
+    if (std::string(argv[i]) == "--perf") {
+      counters.reset(new PerfCounters);
+      if (!counters->isAvailable()) {
+        std::cout << "performance counters are not available" << std::endl;
+      }
+    }
+  }
+  
   ptree allResults;
   allResults.put("msgSize", T);
   allResults.put("blocks", N);
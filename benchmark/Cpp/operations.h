@@ -34,6 +34,7 @@
 #include <itpp/comm/interleave.h>
 
 #include "Turbo.h"
+#include "PerfCounters.h"
 
 const double z = 1.96;
 
@@ -84,14 +85,23 @@ itpp::vec distort(const itpp::bvec& input, double snrdb)
   return llr;
 }
 
-boost::property_tree::ptree fecEncode(const fec::Codec& code, const std::vector<std::vector<fec::BitField<size_t>>>& msg)
+boost::property_tree::ptree fecEncode(const fec::Codec& code, const std::vector<std::vector<fec::BitField<size_t>>>& msg, PerfCounters* counters = nullptr)
 {
   std::vector<double> elapsedTimes(msg.size());
+  if (counters) {
+    counters->clear();
+  }
   for (size_t i = 0; i < msg.size(); ++i) {
+    if (counters) {
+      counters->start();
+    }
     std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
     std::vector<fec::BitField<size_t>> parity;
     code.encode(msg[i], parity);
     std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+    if (counters) {
+      counters->stop();
+    }
     std::chrono::duration<double> time_span = std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1);
     elapsedTimes[i] = time_span.count();
   }
@@ -102,18 +112,36 @@ boost::property_tree::ptree fecEncode(const fec::Codec& code, const std::vector<
   
   double sq_sum = std::inner_product(elapsedTimes.begin(), elapsedTimes.end(), elapsedTimes.begin(), 0.0);
   et.put("intvl", std::sqrt(sq_sum / elapsedTimes.size() - avg * avg) * z / sqrt(msg.size()));
+  if (counters && counters->isAvailable()) {
+    et.put_child("counters", counters->results(double(msg[0].size())));
+  }
   return et;
 }
 
-boost::property_tree::ptree fecDecode(const fec::Codec& code, const std::vector<std::vector<fec::BitField<size_t>>>& msg, const std::vector<std::vector<double>>& llr)
+/**
+ *  Measures the decoding of several batches of blocks.
+ *  \param  counters  Performance counters collected around each decoding, or nullptr
+ *  \param  iterations  Number of iterations of the decoder, used in derived metrics
+ *  \param  edgeCount Number of edges of the code graph, used in derived metrics
+ */
+boost::property_tree::ptree fecDecode(const fec::Codec& code, const std::vector<std::vector<fec::BitField<size_t>>>& msg, const std::vector<std::vector<double>>& llr, PerfCounters* counters = nullptr, double iterations = 1.0, double edgeCount = 0.0)
 {
   std::vector<double> elapsedTimes(llr.size());
   std::vector<double> errorCount(llr.size(), 0);
   std::vector<double> blocErrorCount(llr.size(), 0);
+  if (counters) {
+    counters->clear();
+  }
   for (size_t i = 0; i < llr.size(); ++i) {
+    if (counters) {
+      counters->start();
+    }
     std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
     std::vector<fec::BitField<size_t>> decodedMsg;
     code.decode(llr[i], decodedMsg);
+    if (counters) {
+      counters->stop();
+    }
     for (size_t j = 0; j < msg[i].size()/code.msgSize(); ++j) {
       bool error = false;
       for (size_t k = 0; k < code.msgSize(); ++k) {
@@ -133,6 +161,10 @@ boost::property_tree::ptree fecDecode(const fec::Codec& code, const std::vector<
   
   double sq_sum = std::inner_product(elapsedTimes.begin(), elapsedTimes.end(), elapsedTimes.begin(), 0.0);
   results.put("intvl", std::sqrt(sq_sum / elapsedTimes.size() - avg * avg) * z / sqrt(llr.size()));
+  if (counters && counters->isAvailable()) {
+    double blockCount = double(msg[0].size() / code.msgSize());
+    results.put_child("counters", counters->results(double(msg[0].size()), iterations, edgeCount * blockCount));
+  }
   
   for (size_t i = 0; i < errorCount.size(); ++i) {
     errorCount[i] /= msg[0].size();
@@ -22,7 +22,9 @@
 #ifndef FEC_BIT_MATRIX_H
 #define FEC_BIT_MATRIX_H
 
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/utility.hpp>
 #include <boost/serialization/nvp.hpp>
@@ -60,6 +62,7 @@ class SparseBitMatrix
 public:
   class Constrow;
   class RowRef;
+  class Builder;
   
   /**
    *  This is a const reference to a SparseBitMatrix row with an offset.
@@ -549,7 +552,7 @@ public:
    *  \param[out] dst Vector containing the size of each column
    */
   inline void colSizes(::std::vector<size_t>& dst) const {colSizes({0, rows()}, {0, cols()}, dst);}
-  inline ::std::vector<size_t> colSizes() const {std::vector<size_t> x(rows()); colSizes({0, rows()}, {0, cols()}, x); return x;}
+  inline ::std::vector<size_t> colSizes() const {std::vector<size_t> x(cols()); colSizes({0, rows()}, {0, cols()}, x); return x;}
   /**
    *  Computes the column sizes in the matrix.
    *  We define the column size as the number of non-zero elements
@@ -623,6 +626,70 @@ private:
   ::std::vector<size_t> elementIdx_;
   ::std::vector<RowIdx> rowIdx_;
 };
+
+/**
+ *  This class builds a SparseBitMatrix from its non-zero elements.
+ *  Elements are added in any order, and columns can be permuted over a range of rows
+ *  without moving any element until the matrix is built.
+ *  The matrix and its transpose are built in time linear with the number of elements,
+ *  up to sorting each row.
+ */
+class SparseBitMatrix::Builder
+{
+  /**
+   *  This struct contains a column permutation pending on a range of rows.
+   */
+  struct ColPermutation {
+    ::std::vector<size_t> cols;
+    size_t rowRange[2];
+    size_t size;
+  };
+
+public:
+  Builder() = default;
+  /**
+   *  Builder constructor.
+   *  \param  rows Number of rows
+   *  \param  cols Number of columns
+   */
+  inline Builder(size_t rows, size_t cols) : rows_(rows), cols_(cols) {}
+  
+  inline size_t rows() const {return rows_;}
+  inline size_t cols() const {return cols_;}
+  inline size_t size() const {return rowOf_.size();} /**< Access the number of elements added. */
+  
+  inline void reserve(size_t size) {rowOf_.reserve(size); colOf_.reserve(size);}
+  inline void set(size_t i, size_t j);
+  
+  /**
+   *  Permutes the columns of every row.
+   *  \param  permutation New index of each column
+   */
+  inline void permuteCols(const ::std::vector<size_t>& permutation) {permuteCols(permutation, {0, rows()});}
+  inline void permuteCols(const ::std::vector<size_t>& permutation, const size_t rowRange[2]);
+  /**
+   *  Permutes the columns of a range of rows.
+   *  \param  permutation New index of each column
+   *  \param  rowRange  Begin and end row involved in the operation
+   */
+  inline void permuteCols(const ::std::vector<size_t>& permutation, const ::std::initializer_list<size_t>& rowRange) {permuteCols(permutation, rowRange.begin());}
+  
+  inline SparseBitMatrix matrix() const;
+  inline SparseBitMatrix transpose() const {return matrix().transpose();} /**< Builds the transpose of the matrix. */
+  /**
+   *  Builds the matrix and its transpose, giving access to the elements by row and by column.
+   *  \param[out]  x Matrix containing the elements added
+   *  \param[out]  xt Transpose of x
+   */
+  inline void build(SparseBitMatrix& x, SparseBitMatrix& xt) const {x = matrix(); xt = x.transpose();}
+
+private:
+  size_t rows_ = 0;
+  size_t cols_ = 0;
+  ::std::vector<size_t> rowOf_;
+  ::std::vector<size_t> colOf_;
+  ::std::vector<ColPermutation> permutations_;
+};
   
 }
 
@@ -757,6 +824,11 @@ public:
   
   inline void deleteRow(std::vector<Row>::iterator a) {rows_.erase(a);}
   
+  inline BitMatrix transpose() const;
+  inline BitMatrix operator * (const BitMatrix& b) const;
+  inline void eliminate(const std::vector<size_t>& pivotRows, const std::vector<size_t>& pivotCols);
+  static size_t groupSize() {return 8;} /**< Access the number of rows combined in a table of the Method of Four Russians. */
+
 private:
   template <typename Archive>
   void serialize(Archive & ar, const unsigned int version) {
@@ -766,6 +838,9 @@ private:
   }
   
   inline void resize(size_t rows, size_t cols);
+  inline void combinations(const std::vector<const Row*>& rows, std::vector<Row>& table) const;
+  static inline void transposeBloc(size_t* bloc);
+  static size_t blocSize() {return sizeof(size_t) * 8;}
   
   size_t cols_ = 0;
   std::vector<Row> rows_;
@@ -935,11 +1010,10 @@ void fec::SparseBitMatrix::colSizes(const size_t rowRange[2], const size_t colRa
   dst.resize(colRange[1] - colRange[0], 0);
   std::fill(dst.begin(), dst.end(), 0);
   for (auto row = begin()+rowRange[0]; row < begin()+rowRange[1]; ++row) {
-    auto elem = row->begin();
-    while (*elem < colRange[0]) ++elem;
+    auto elem = std::lower_bound(row->begin(), row->end(), colRange[0]);
     while (elem < row->end() && *elem < colRange[1])
     {
-      dst[*elem]++;
+      dst[*elem - colRange[0]]++;
       ++elem;
     }
   }
@@ -1001,6 +1075,77 @@ fec::SparseBitMatrix fec::SparseBitMatrix::transpose() const
   return x;
 }
 
+/**
+ *  Adds a non-zero element.
+ *  Adding an element twice has the same effect as adding it once.
+ *  Pending column permutations do not apply to the elements added after them.
+ *  \param  i Row of the element
+ *  \param  j Column of the element
+ */
+void fec::SparseBitMatrix::Builder::set(size_t i, size_t j)
+{
+  if (i >= rows() || j >= cols()) {
+    throw std::invalid_argument("Invalid index");
+  }
+  rowOf_.push_back(i);
+  colOf_.push_back(j);
+}
+
+/**
+ *  Permutes the columns of a range of rows.
+ *  The element in column j is moved to column permutation[j] when the matrix is built.
+ *  \param  permutation New index of each column
+ *  \param  rowRange  Begin and end row involved in the operation
+ */
+void fec::SparseBitMatrix::Builder::permuteCols(const std::vector<size_t>& permutation, const size_t rowRange[2])
+{
+  if (permutation.size() != cols()) {
+    throw std::invalid_argument("Invalid permutation size");
+  }
+  if (rowRange[0] > rowRange[1] || rowRange[1] > rows()) {
+    throw std::invalid_argument("Invalid row range");
+  }
+  permutations_.push_back({permutation, {rowRange[0], rowRange[1]}, size()});
+}
+
+/**
+ *  Builds the matrix.
+ *  Elements are scattered to their row, then each row is sorted.
+ *  \return Matrix containing the elements added
+ */
+fec::SparseBitMatrix fec::SparseBitMatrix::Builder::matrix() const
+{
+  std::vector<size_t> colIdx = colOf_;
+  for (auto& permutation : permutations_) {
+    for (size_t e = 0; e < permutation.size; ++e) {
+      if (rowOf_[e] >= permutation.rowRange[0] && rowOf_[e] < permutation.rowRange[1]) {
+        colIdx[e] = permutation.cols[colIdx[e]];
+      }
+    }
+  }
+  
+  std::vector<size_t> rowSizes(rows(), 0);
+  for (size_t e = 0; e < size(); ++e) {
+    ++rowSizes[rowOf_[e]];
+  }
+  SparseBitMatrix x(rowSizes, cols());
+  for (size_t e = 0; e < size(); ++e) {
+    x[rowOf_[e]].set(colIdx[e]);
+  }
+  bool isDuplicated = false;
+  for (auto& rowIdx : x.rowIdx_) {
+    auto first = x.elementIdx_.begin() + rowIdx.begin;
+    std::sort(first, x.elementIdx_.begin() + rowIdx.end);
+    size_t end = std::unique(first, x.elementIdx_.begin() + rowIdx.end) - x.elementIdx_.begin();
+    isDuplicated |= (end != rowIdx.end);
+    rowIdx.end = end;
+  }
+  if (isDuplicated) {
+    return SparseBitMatrix(x);
+  }
+  return x;
+}
+
 /**
  *  Resize the matrix to a specified shape.
  *  Data in the matrix may become invalid.
@@ -1196,12 +1341,8 @@ fec::BitMatrix::BitMatrix(const SparseBitMatrix& b)
   resize(b.rows(), b.cols());
   auto row = begin();
   for (auto bRow = b.begin(); bRow != b.end(); ++bRow, ++row) {
-    auto bElem = bRow->begin();
-    for (size_t j = 0; j < b.cols() && bElem < bRow->end(); ++j) {
-      if (*bElem == j) {
-        row->set(j);
-        ++bElem;
-      }
+    for (auto bElem = bRow->begin(); bElem < bRow->end(); ++bElem) {
+      row->set(*bElem);
     }
   }
 }
@@ -1290,6 +1431,142 @@ void fec::BitMatrix::resize(size_t rows, size_t cols)
   }
 }
 
+/**
+ *  Return the transpose of the matrix.
+ *  The matrix is processed by square blocs of one word per row,
+ *  each bloc being transposed in registers.
+ *  \return transposed matrix
+ */
+fec::BitMatrix fec::BitMatrix::transpose() const
+{
+  BitMatrix x(cols(), rows());
+  std::vector<size_t> bloc(blocSize());
+  for (size_t i = 0; i < rows(); i += blocSize()) {
+    size_t rowCount = std::min(blocSize(), rows() - i);
+    for (size_t j = 0; j < cols(); j += blocSize()) {
+      size_t colCount = std::min(blocSize(), cols() - j);
+      for (size_t k = 0; k < blocSize(); ++k) {
+        bloc[k] = (k < rowCount) ? size_t(rows_[i+k].elements_[j/blocSize()]) : 0;
+      }
+      transposeBloc(bloc.data());
+      for (size_t k = 0; k < colCount; ++k) {
+        x.rows_[j+k].elements_[i/blocSize()] = bloc[k];
+      }
+    }
+  }
+  return x;
+}
+
+/**
+ *  Transposes in place a square bloc of blocSize() words.
+ *  Quadrants of decreasing size are swapped with masks and shifts.
+ *  \param bloc Pointer to the first word of the bloc
+ */
+void fec::BitMatrix::transposeBloc(size_t* bloc)
+{
+  size_t mask = (size_t(1) << (blocSize()/2)) - 1;
+  for (size_t j = blocSize()/2; j != 0; j >>= 1, mask ^= (mask << j)) {
+    for (size_t k = 0; k < blocSize(); k = ((k | j) + 1) & ~j) {
+      size_t t = ((bloc[k] >> j) ^ bloc[k | j]) & mask;
+      bloc[k] ^= t << j;
+      bloc[k | j] ^= t;
+    }
+  }
+}
+
+/**
+ *  Computes the modulo-2 product of two matrices.
+ *  The Method of Four Russians is used.
+ *  Rows of b are taken by groups of groupSize(), and all their combinations are tabulated,
+ *  such that each row of the product is updated once per group.
+ *  \param b Right hand side matrix
+ *  \return product
+ */
+fec::BitMatrix fec::BitMatrix::operator * (const BitMatrix& b) const
+{
+  if (cols() != b.rows()) {
+    throw std::invalid_argument("Invalid size for matrix product");
+  }
+  BitMatrix x(rows(), b.cols());
+  std::vector<Row> table;
+  std::vector<const Row*> group;
+  for (size_t j = 0; j < cols(); j += groupSize()) {
+    group.clear();
+    for (size_t k = j; k < std::min(j + groupSize(), cols()); ++k) {
+      group.push_back(&b[k]);
+    }
+    combinations(group, table);
+    for (size_t i = 0; i < rows(); ++i) {
+      size_t index = (rows_[i].elements_[j/blocSize()] >> (j%blocSize())) & ((size_t(1) << group.size()) - 1);
+      if (index != 0) {
+        x.rows_[i] += table[index];
+      }
+    }
+  }
+  return x;
+}
+
+/**
+ *  Clears the pivot columns from every row other than the pivot rows.
+ *  Each pivot row must have a 1 in its pivot column and 0 in the other pivot columns.
+ *  Pivots are taken by groups of groupSize(), whose row combinations are tabulated
+ *  as in the Method of Four Russians,
+ *  such that each row is updated once per group.
+ *  \param pivotRows Index of the pivot rows
+ *  \param pivotCols Index of the column of each pivot
+ */
+void fec::BitMatrix::eliminate(const std::vector<size_t>& pivotRows, const std::vector<size_t>& pivotCols)
+{
+  std::vector<bool> isPivot(rows(), false);
+  for (auto i : pivotRows) {
+    isPivot[i] = true;
+  }
+  std::vector<Row> table;
+  std::vector<const Row*> group;
+  for (size_t j = 0; j < pivotRows.size(); j += groupSize()) {
+    size_t groupEnd = std::min(j + groupSize(), pivotRows.size());
+    group.clear();
+    for (size_t k = j; k < groupEnd; ++k) {
+      group.push_back(&rows_[pivotRows[k]]);
+    }
+    combinations(group, table);
+    for (size_t i = 0; i < rows(); ++i) {
+      if (isPivot[i]) {
+        continue;
+      }
+      size_t index = 0;
+      for (size_t k = j; k < groupEnd; ++k) {
+        index |= size_t(rows_[i].test(pivotCols[k])) << (k - j);
+      }
+      if (index != 0) {
+        rows_[i] += table[index];
+      }
+    }
+  }
+}
+
+/**
+ *  Tabulates the modulo-2 sums of every subset of rows.
+ *  Entry i of the table is the sum of the rows whose index is set in i.
+ *  Each entry is computed from a previous one with a single row addition.
+ *  \param rows  Rows to combine
+ *  \param table[out] Table of 2^rows.size() rows
+ */
+void fec::BitMatrix::combinations(const std::vector<const Row*>& rows, std::vector<Row>& table) const
+{
+  size_t width = rows.empty() ? 0 : rows[0]->elements_.size();
+  table.resize(size_t(1) << rows.size());
+  table[0].elements_.assign(width, 0);
+  for (size_t i = 1; i < table.size(); ++i) {
+    size_t k = 0;
+    while (((i >> k) & 1) == 0) {
+      ++k;
+    }
+    table[i] = table[i & (i-1)];
+    table[i] += *rows[k];
+  }
+}
+
 inline std::ostream& operator<<(std::ostream& os, const fec::BitMatrix& matrix)
 {
   if (matrix.rows() == 0) {
@@ -19,31 +19,103 @@
  along with FeCl.  If not, see <http://www.gnu.org/licenses/>.
  ******************************************************************************/
 
+#include <atomic>
+#include <chrono>
+
 #include "Codec.h"
+#include "detail/Arena.h"
+#include "detail/Numa.h"
 
 using namespace fec;
 
 BOOST_CLASS_EXPORT_IMPLEMENT(Codec);
 
+namespace {
+  
+  /**
+   *  Structure replica and decoders used by the current thread while it processes blocks of a codec.
+   */
+  thread_local const Codec* localCodec = nullptr;
+  thread_local const detail::Codec::Structure* localStructure = nullptr;
+  thread_local detail::Codec::WorkerCache* localCache = nullptr;
+  
+  /**
+   *  Arena taken from a pool for the lifetime of the object.
+   */
+  class ArenaLease {
+  public:
+    ArenaLease(MemoryPool* pool) : pool_(pool) {
+      if (pool_ != nullptr) {
+        arena_ = pool_->acquire();
+      }
+    }
+    ~ArenaLease() {
+      if (pool_ != nullptr) {
+        pool_->release(arena_);
+      }
+    }
+    ArenaLease(const ArenaLease&) = delete;
+    ArenaLease& operator=(const ArenaLease&) = delete;
+    
+    detail::Arena* get() const {return arena_;}
+  
+  private:
+    MemoryPool* pool_;
+    detail::Arena* arena_ = nullptr;
+  };
+
+}
+
 Codec::Codec(std::unique_ptr<detail::Codec::Structure>&& structure, int workGroupSize) : structure_(std::move(structure))
 {
   workGroupSize_ = workGroupSize;
 }
 
+Codec& Codec::operator=(const Codec& other)
+{
+  workGroupSize_ = other.getWorkGroupSize();
+  numaAware_ = other.getNumaAware();
+  memoryPool_ = other.getMemoryPool();
+  std::lock_guard<std::mutex> lock(replicasMutex_);
+  replicas_.clear();
+  return *this;
+}
+
+/**
+ *  Access the codec structure.
+ *  A thread processing blocks on a NUMA node accesses the copy of the structure local to its node.
+ */
+const detail::Codec::Structure& Codec::structure() const
+{
+  if (localCodec == this) {
+    return *localStructure;
+  }
+  return *structure_;
+}
+
 /**
- *  Checks several blocs of msg bits.
- *  \param  parityIt Input iterator pointing to the first element in the parity bit sequence.
+ *  Access the codec structure for modification.
+ *  Copies of the structure made for NUMA nodes are discarded.
  */
-bool Codec::checkBlocks(std::vector<BitField<size_t>>::const_iterator parity, size_t n) const
+detail::Codec::Structure& Codec::structure()
+{
+  std::lock_guard<std::mutex> lock(replicasMutex_);
+  replicas_.clear();
+  return *structure_;
+}
+
+/**
+ *  Checks several blocs of parity bits.
+ *  \param  parity Input iterator pointing to the first element in the parity bit sequence.
+ *  \param  result[out] Output iterator pointing to the first element in the check result sequence.
+ *    The output neeeds to be pre-allocated.
+ */
+void Codec::checkBlocks(std::vector<BitField<size_t>>::const_iterator parity, std::vector<BitField<size_t>>::iterator result, size_t n) const
 {
   for (size_t i = 0; i < n; ++i) {
-    bool check = structure().check(parity);
-    if (!check) {
-      return false;
-    }
+    result[i] = structure().check(parity);
     parity += paritySize();
   }
-  return true;
 }
 
 /**
@@ -61,18 +133,181 @@ void Codec::encodeBlocks(std::vector<BitField<size_t>>::const_iterator msg, std:
   }
 }
 
-std::vector<std::thread> Codec::createWorkGroup() const
+/**
+ *  Decodes several blocs of information bits, each before its deadline.
+ *  This is used by codecs without iterative decoding, which run to completion
+ *  and always consider their blocks converged.
+ *  \param  parity  Input iterator pointing to the first element in the parity L-value sequence.
+ *  \param  msg[out] Output iterator pointing to the first element in the decoded msg sequence.
+ *  \param  converged[out] Output iterator pointing to the first element in the convergence flag sequence.
+ *  \param  deadline Budget shared by the blocks of the batch
+ */
+void Codec::timedDecodeBlocks(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, std::vector<BitField<size_t>>::iterator converged, size_t n, detail::Codec::Deadline& deadline) const
 {
+  for (size_t i = 0; i < n; ++i) {
+    deadline.next();
+    converged[i] = 1;
+  }
+  decodeBlocks(parity, msg, n);
+}
+
+/**
+ *  Access timing information about the last batch of blocks processed by the codec.
+ *  When the codec is used concurrently by several callers, this is the last batch to complete.
+ *  \return Batch statistics
+ */
+Codec::BatchStatistics Codec::getBatchStatistics() const
+{
+  std::lock_guard<std::mutex> lock(batchStatisticsMutex_);
+  return batchStatistics_;
+}
+
+/**
+ *  Processes several blocks concurrently.
+ *  Threads repeatedly take the next range of blocks from a shared atomic cursor
+ *  until every block is processed, such that all threads stay busy until the last block
+ *  even when the cost of blocks varies.
+ *  Ranges are small enough to be handed out several times to each thread
+ *  and for the data of a range to fit in cache.
+ *  The calling thread is one of the workers.
+ *  Each thread keeps its decoders from one range to the next.
+ *  When the codec has a memory pool, each thread takes an arena from it,
+ *  and the workspaces allocated while processing the batch are released after it.
+ *
+ *  When the codec is NUMA aware and the machine has several nodes,
+ *  threads are spread over the nodes and there is one cursor per node.
+ *  Each range is queued on the node holding its input, and a thread takes ranges
+ *  from its own node before helping the other nodes,
+ *  which also empties the queues of nodes left without thread when there are fewer threads than nodes.
+ *  \param  blockCount Number of blocks
+ *  \param  blockBytes Size of the data accessed for each block
+ *  \param  task Function processing a range of blocks, given its first block and its number of blocks
+ *  \param  input Address of the input of the first block, used to find the node of each range
+ *  \param  inputBytes Size of the input of each block
+ */
+void Codec::runBlocks(size_t blockCount, size_t blockBytes, const std::function<void(size_t, size_t)>& task, const void* input, size_t inputBytes) const
+{
+  const size_t chunkBytes = 256 * 1024;
+  const size_t chunkPerWorker = 4;
+  
+  size_t workers = workerCount(blockCount);
+  size_t chunkSize = blockCount / (workers * chunkPerWorker);
+  chunkSize = std::min(chunkSize, chunkBytes / std::max(blockBytes, size_t(1)));
+  chunkSize = std::max(chunkSize, size_t(1));
+  
+  const auto& topology = detail::Numa::Topology::get();
+  size_t nodeCount = 1;
+  if (getNumaAware() && input != nullptr && workers > 1) {
+    nodeCount = topology.nodeCount();
+  }
+  std::vector<std::vector<size_t>> chunks(nodeCount);
+  for (size_t first = 0; first < blockCount; first += chunkSize) {
+    size_t node = 0;
+    if (nodeCount > 1) {
+      node = topology.nodeOf(static_cast<const char*>(input) + first * inputBytes);
+    }
+    chunks[node].push_back(first);
+  }
+  std::unique_ptr<std::atomic<size_t>[]> cursors(new std::atomic<size_t>[nodeCount]);
+  for (size_t i = 0; i < nodeCount; ++i) {
+    cursors[i] = 0;
+  }
+  
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::chrono::steady_clock::time_point> finish(workers);
+  std::atomic<size_t> chunkCount(0);
+  auto worker = [&](size_t id) {
+    size_t node = id % nodeCount;
+    std::unique_ptr<detail::Numa::ThreadBinding> binding;
+    auto previousCodec = localCodec;
+    auto previousStructure = localStructure;
+    auto previousCache = localCache;
+    localStructure = structure_.get();
+    if (nodeCount > 1) {
+      binding.reset(new detail::Numa::ThreadBinding(node));
+      localStructure = replica(node);
+    }
+    ArenaLease arena(memoryPool_.get());
+    {
+      detail::Arena::Scope scope(arena.get());
+      detail::Codec::WorkerCache cache;
+      localCodec = this;
+      localCache = &cache;
+      for (size_t k = 0; k < nodeCount; ++k) {
+        size_t queue = (node + k) % nodeCount;
+        for (size_t i = cursors[queue]++; i < chunks[queue].size(); i = cursors[queue]++) {
+          size_t first = chunks[queue][i];
+          task(first, std::min(chunkSize, blockCount - first));
+          ++chunkCount;
+        }
+      }
+      localCodec = previousCodec;
+      localStructure = previousStructure;
+      localCache = previousCache;
+    }
+    finish[id] = std::chrono::steady_clock::now();
+  };
+  
   std::vector<std::thread> threadGroup;
-  threadGroup.reserve(getWorkGroupSize());
-  return threadGroup;
+  threadGroup.reserve(workers-1);
+  for (size_t i = 1; i < workers; ++i) {
+    threadGroup.push_back( std::thread(worker, i) );
+  }
+  worker(0);
+  for (auto & thread : threadGroup) {
+    thread.join();
+  }
+  
+  auto last = *std::max_element(finish.begin(), finish.end());
+  auto first = *std::min_element(finish.begin(), finish.end());
+  BatchStatistics statistics;
+  statistics.blockCount = blockCount;
+  statistics.workerCount = workers;
+  statistics.chunkCount = chunkCount;
+  statistics.duration = std::chrono::duration<double>(last - start).count();
+  statistics.tail = std::chrono::duration<double>(last - first).count();
+  std::lock_guard<std::mutex> lock(batchStatisticsMutex_);
+  batchStatistics_ = statistics;
 }
 
-size_t Codec::taskSize(size_t blockCount) const
+/**
+ *  Access the copy of the structure local to a NUMA node, creating it on first use.
+ *  The copy is made by a thread bound to the node, such that its memory is allocated on the node.
+ *  \param  node Node index
+ */
+const detail::Codec::Structure* Codec::replica(size_t node) const
+{
+  std::lock_guard<std::mutex> lock(replicasMutex_);
+  if (replicas_.size() <= node) {
+    replicas_.resize(node+1);
+  }
+  if (!replicas_[node]) {
+    replicas_[node] = std::unique_ptr<detail::Codec::Structure>(structure_->clone());
+  }
+  return replicas_[node].get();
+}
+
+/**
+ *  Access the decoders of the calling thread.
+ *  \return Decoders kept by the thread for the batch of the codec it is processing, or nullptr outside of a batch
+ */
+detail::Codec::WorkerCache* Codec::workerCache() const
+{
+  if (localCodec == this) {
+    return localCache;
+  }
+  return nullptr;
+}
+
+/**
+ *  Computes the number of threads processing a batch.
+ *  This is the number of hardware threads, limited by the work group size and by the number of blocks.
+ */
+size_t Codec::workerCount(size_t blockCount) const
 {
-  int n = std::thread::hardware_concurrency();
-  if (n > getWorkGroupSize() || n == 0) {
+  size_t n = std::thread::hardware_concurrency();
+  if (n > size_t(getWorkGroupSize()) || n == 0) {
     n = getWorkGroupSize();
   }
-  return (blockCount+n-1)/n;
+  return std::max(std::min(n, blockCount), size_t(1));
 }
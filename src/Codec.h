@@ -22,7 +22,10 @@
 #ifndef FEC_CODEC_H
 #define FEC_CODEC_H
 
+#include <algorithm>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <vector>
 
@@ -34,6 +37,7 @@
 #include <boost/serialization/type_info_implementation.hpp>
 #include <boost/serialization/extended_type_info_no_rtti.hpp>
 
+#include "MemoryPool.h"
 #include "detail/Codec.h"
 
 namespace fec {
@@ -53,6 +57,17 @@ namespace fec {
     template <template <typename> class A = std::allocator>
     using Output = detail::Codec::Info<std::vector<double,A<double>>>;
     
+    /**
+     *  This struct contains timing information about the last batch of blocks processed by a codec.
+     */
+    struct BatchStatistics {
+      size_t blockCount = 0; /**< Number of blocks in the batch */
+      size_t workerCount = 0; /**< Number of threads processing the batch */
+      size_t chunkCount = 0; /**< Number of block ranges handed out to the threads */
+      double duration = 0.0; /**< Time from the start of the batch to the end of the last thread, in seconds */
+      double tail = 0.0; /**< Time from the end of the first thread to the end of the last thread, in seconds */
+    };
+    
     virtual ~Codec() = default;
     
     virtual const char * get_key() const = 0; /**< Access the type info key. */
@@ -64,9 +79,30 @@ namespace fec {
     
     int getWorkGroupSize() const {return workGroupSize_;}
     void setWorkGroupSize(int size) {workGroupSize_ = size;}
+    /**
+     *  Access wether batches are distributed over the NUMA nodes of the machine.
+     *  When enabled, threads are bound to nodes, each node uses its own copy of the codec structure,
+     *  and blocks are processed first by threads on the node holding their input.
+     *  This has no effect on machines with a single node.
+     */
+    bool getNumaAware() const {return numaAware_;}
+    void setNumaAware(bool numaAware) {numaAware_ = numaAware;}
+    /**
+     *  Access the pool in which the workspaces of the decoders are allocated.
+     *  Each thread processing blocks takes an arena from the pool for the batch,
+     *  and the workspaces of its decoders are released at the end of the batch.
+     *  Without a pool, workspaces are allocated from the heap.
+     */
+    std::shared_ptr<MemoryPool> getMemoryPool() const {return memoryPool_;}
+    void setMemoryPool(const std::shared_ptr<MemoryPool>& memoryPool) {memoryPool_ = memoryPool;}
+    BatchStatistics getBatchStatistics() const; /**< Access timing information about the last batch. */
     
     template <template <typename> class A>
     bool check(const std::vector<BitField<size_t>,A<BitField<size_t>>>& parity) const;
+    template <template <typename> class A>
+    void checkEach(const std::vector<BitField<size_t>,A<BitField<size_t>>>& parity, std::vector<BitField<size_t>,A<BitField<size_t>>>& result) const;
+    template <template <typename> class A>
+    std::vector<BitField<size_t>,A<BitField<size_t>>> checkEach(const std::vector<BitField<size_t>,A<BitField<size_t>>>& parity) const;
     
     template <template <typename> class A>
     void encode(const std::vector<BitField<size_t>,A<BitField<size_t>>>& message, std::vector<BitField<size_t>,A<BitField<size_t>>>& parity) const;
@@ -77,6 +113,8 @@ namespace fec {
     void decode(const std::vector<double,A<double>>& parity, std::vector<BitField<size_t>,A<BitField<size_t>>>& msg) const;
     template <template <typename> class A>
     std::vector<BitField<size_t>,A<BitField<size_t>>> decode(const std::vector<double,A<double>>& parity) const;
+    template <template <typename> class A>
+    void decode(const std::vector<double,A<double>>& parity, std::vector<BitField<size_t>,A<BitField<size_t>>>& msg, std::vector<BitField<size_t>,A<BitField<size_t>>>& converged, double budget) const;
     
     template <template <typename> class A>
     void soDecode(Input<A> input, Output<A> output) const;
@@ -86,12 +124,12 @@ namespace fec {
     Codec(std::unique_ptr<detail::Codec::Structure>&&, int workGroupSize = 8);
     
     Codec(const Codec& other) {*this = other;}
-    Codec& operator=(const Codec& other) {workGroupSize_ = other.getWorkGroupSize(); return *this;}
+    Codec& operator=(const Codec& other);
     
-    inline const detail::Codec::Structure& structure() const {return *structure_;}
-    inline detail::Codec::Structure& structure() {return *structure_;}
+    const detail::Codec::Structure& structure() const;
+    detail::Codec::Structure& structure();
     
-    virtual bool checkBlocks(std::vector<BitField<size_t>>::const_iterator parity, size_t n) const;
+    virtual void checkBlocks(std::vector<BitField<size_t>>::const_iterator parity, std::vector<BitField<size_t>>::iterator result, size_t n) const;
     virtual void encodeBlocks(std::vector<BitField<size_t>>::const_iterator msg, std::vector<BitField<size_t>>::iterator parity, size_t n) const;
     
     /**
@@ -113,6 +151,11 @@ namespace fec {
      *    Output needs to be pre-allocated.
      */
     virtual void soDecodeBlocks(detail::Codec::InputIterator input, detail::Codec::OutputIterator output, size_t n) const = 0;
+    virtual void timedDecodeBlocks(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, std::vector<BitField<size_t>>::iterator converged, size_t n, detail::Codec::Deadline& deadline) const;
+    
+    void runBlocks(size_t blockCount, size_t blockBytes, const std::function<void(size_t, size_t)>& task, const void* input = nullptr, size_t inputBytes = 0) const;
+    template <class Decoder, class Create>
+    std::shared_ptr<Decoder> workerDecoder(Create create) const;
     
     std::unique_ptr<detail::Codec::Structure> structure_;
     
@@ -120,10 +163,19 @@ namespace fec {
     template <typename Archive>
     void serialize(Archive & ar, const unsigned int version);
     
-    std::vector<std::thread> createWorkGroup() const;
-    size_t taskSize(size_t blockCount) const;
+    size_t workerCount(size_t blockCount) const;
+    detail::Codec::WorkerCache* workerCache() const;
+    const detail::Codec::Structure* replica(size_t node) const;
     
     int workGroupSize_;
+    bool numaAware_ = false;
+    std::shared_ptr<MemoryPool> memoryPool_;
+    
+    mutable std::mutex replicasMutex_;
+    mutable std::vector<std::unique_ptr<detail::Codec::Structure>> replicas_;
+    
+    mutable std::mutex batchStatisticsMutex_;
+    mutable BatchStatistics batchStatistics_;
   };
   
 }
@@ -134,14 +186,51 @@ BOOST_SERIALIZATION_ASSUME_ABSTRACT(fec::Codec);
 BOOST_CLASS_TYPE_INFO(fec::Codec,extended_type_info_no_rtti<fec::Codec>);
 BOOST_CLASS_EXPORT_KEY(fec::Codec);
 
+/**
+ *  Checks several blocks of parity bits for consistency.
+ *  \param  parity  Vector containing parity bits
+ *  \return True if every block is consistent. False otherwise.
+ */
 template <template <typename> class A>
 bool fec::Codec::check(const std::vector<BitField<size_t>,A<BitField<size_t>>>& parity) const
+{
+  auto result = checkEach(parity);
+  return std::all_of(result.begin(), result.end(), [](BitField<size_t> x) {return x != 0;});
+}
+
+template <template <typename> class A>
+std::vector<fec::BitField<size_t>,A<fec::BitField<size_t>>> fec::Codec::checkEach(const std::vector<fec::BitField<size_t>,A<fec::BitField<size_t>>>& parity) const
+{
+  std::vector<fec::BitField<size_t>,A<fec::BitField<size_t>>> result;
+  checkEach(parity, result);
+  return result;
+}
+
+/**
+ *  Checks several blocks of parity bits for consistency, giving one result per block.
+ *  Chunks of blocs are checked in parallel.
+ *  \param  parity  Vector containing parity bits
+ *  \param  result[out] Vector containing 1 for each consistent block and 0 otherwise
+ *  \tparam A Container allocator. The reason for different allocator is to allow
+ *    the matlab API to use a custom mex allocator
+ */
+template <template <typename> class A>
+void fec::Codec::checkEach(const std::vector<BitField<size_t>,A<BitField<size_t>>>& parity, std::vector<BitField<size_t>,A<BitField<size_t>>>& result) const
 {
   uint64_t blockCount = parity.size() / (paritySize());
   if (parity.size() != blockCount * paritySize()) {
     throw std::invalid_argument("Invalid size for parity");
   }
-  return checkBlocks(parity.begin(), blockCount);
+  
+  result.resize(blockCount, 0);
+  if (blockCount == 0) {
+    return;
+  }
+  auto parityIt = parity.begin(); auto resultIt = result.begin();
+  
+  runBlocks(blockCount, paritySize() * sizeof(BitField<size_t>), [&](size_t first, size_t n) {
+    checkBlocks(parityIt + paritySize() * first, resultIt + first, n);
+  }, parity.data(), paritySize() * sizeof(BitField<size_t>));
 }
 
 template <template <typename> class A>
@@ -179,22 +268,9 @@ void fec::Codec::encode(const std::vector<BitField<size_t>,A<BitField<size_t>>>&
   parity.resize(blockCount * paritySize(), 0);
   auto msgIt = msg.begin(); auto parityIt = parity.begin();
   
-  auto threadGroup = createWorkGroup();
-  auto thread = threadGroup.begin();
-  size_t step = taskSize(blockCount);
-  for (int i = 0; i + step <= blockCount; i += step) {
-    threadGroup.push_back( std::thread(&Codec::encodeBlocks, this, msgIt, parityIt, step) );
-    msgIt += msgSize() * step;
-    parityIt += paritySize() * step;
-    
-    ++thread;
-  }
-  if (msgIt != msg.end()) {
-    encodeBlocks(msgIt, parityIt, blockCount % step);
-  }
-  for (auto & thread : threadGroup) {
-    thread.join();
-  }
+  runBlocks(blockCount, (msgSize() + paritySize()) * sizeof(BitField<size_t>), [&](size_t first, size_t n) {
+    encodeBlocks(msgIt + msgSize() * first, parityIt + paritySize() * first, n);
+  }, msg.data(), msgSize() * sizeof(BitField<size_t>));
 }
 
 /**
@@ -218,23 +294,54 @@ void fec::Codec::decode(const std::vector<double,A<double>>& parity, std::vector
   msg.resize(blockCount * msgSize());
   auto parityInIt = parity.begin(); auto msgOutIt = msg.begin();
   
-  auto threadGroup = createWorkGroup();
-  auto thread = threadGroup.begin();
-  size_t step = taskSize(blockCount);
-  for (int i = 0; i + step <= blockCount; i += step) {
-    threadGroup.push_back( std::thread(&Codec::decodeBlocks, this,
-                                       parityInIt, msgOutIt, step) );
-    parityInIt += paritySize() * step;
-    msgOutIt += msgSize() * step;
-    
-    ++thread;
+  runBlocks(blockCount, paritySize() * sizeof(double) + msgSize() * sizeof(BitField<size_t>), [&](size_t first, size_t n) {
+    decodeBlocks(parityInIt + paritySize() * first, msgOutIt + msgSize() * first, n);
+  }, parity.data(), paritySize() * sizeof(double));
+}
+
+/**
+ *  Decodes several blocks of information bits within a wall-clock budget.
+ *  Each block is given a share of the time left when it starts,
+ *  and iterative decoders stop at the end of the iteration reaching it.
+ *  Blocks converging early leave their time to the following blocks,
+ *  such that every iteration is run when the load is light,
+ *  while the decoding ends around the budget under heavy load.
+ *  Best-effort decisions are given for every block.
+ *  \param  parityIn  Vector containing parity L-values
+ *  \param  messageOut[out] Vector containing message bits
+ *  \param  converged[out] Vector containing 1 for each block detected as converged
+ *    and 0 for each block stopped by its deadline or by the maximum number of iterations.
+ *    Blocks of non-iterative codecs are always considered converged.
+ *  \param  budget Time allowed to decode every block, in seconds.
+ *    An unlimited budget, such as infinity, decodes every block exactly as without budget.
+ *  \tparam A Container allocator. The reason for different allocator is to allow
+ *    the matlab API to use a custom mex allocator
+ */
+template <template <typename> class A>
+void fec::Codec::decode(const std::vector<double,A<double>>& parity, std::vector<BitField<size_t>,A<BitField<size_t>>>& msg, std::vector<BitField<size_t>,A<BitField<size_t>>>& converged, double budget) const
+{
+  size_t blockCount = parity.size() / paritySize();
+  if (parity.size() != blockCount * paritySize()) {
+    throw std::invalid_argument("Invalid size for parity");
   }
-  if (msgOutIt != msg.end()) {
-    decodeBlocks(parityInIt, msgOutIt, blockCount % step);
+  if (!(budget >= 0.0)) {
+    throw std::invalid_argument("Invalid budget");
   }
-  for (auto & thread : threadGroup) {
-    thread.join();
+  
+  msg.resize(blockCount * msgSize());
+  converged.resize(blockCount);
+  auto parityInIt = parity.begin(); auto msgOutIt = msg.begin(); auto convergedIt = converged.begin();
+  
+  auto end = detail::Codec::Deadline::Clock::time_point::max();
+  const double maxBudget = 3.0e7;
+  if (budget < maxBudget) {
+    end = detail::Codec::Deadline::Clock::now() + std::chrono::duration_cast<detail::Codec::Deadline::Clock::duration>(std::chrono::duration<double>(budget));
   }
+  detail::Codec::Deadline deadline(end, blockCount, workerCount(blockCount));
+  
+  runBlocks(blockCount, paritySize() * sizeof(double) + msgSize() * sizeof(BitField<size_t>), [&](size_t first, size_t n) {
+    timedDecodeBlocks(parityInIt + paritySize() * first, msgOutIt + msgSize() * first, convergedIt + first, n, deadline);
+  }, parity.data(), paritySize() * sizeof(double));
 }
 
 /**
@@ -285,25 +392,30 @@ void fec::Codec::soDecode(Input<A> input, Output<A> output) const
   auto inputIt = input.begin(structure());
   auto outputIt = output.begin(structure());
   
-  auto threadGroup = createWorkGroup();
-  auto thread = threadGroup.begin();
-  size_t step = taskSize(blockCount);
-  for (int i = 0; i + step <= blockCount; i += step) {
-    threadGroup.push_back( std::thread(&Codec::soDecodeBlocks, this,
-                                       inputIt,
-                                       outputIt, step
-                                       ) );
-    inputIt += step;
-    outputIt += step;
-    
-    thread++;
-  }
-  if (outputIt != output.end(structure())) {
-    soDecodeBlocks(inputIt, outputIt, blockCount % step);
-  }
-  for (auto & thread : threadGroup) {
-    thread.join();
+  runBlocks(blockCount, 2 * (paritySize() + systSize() + stateSize()) * sizeof(double), [&](size_t first, size_t n) {
+    auto inputFirst = inputIt;
+    auto outputFirst = outputIt;
+    inputFirst += first;
+    outputFirst += first;
+    soDecodeBlocks(inputFirst, outputFirst, n);
+  }, input.parity().data(), paritySize() * sizeof(double));
+}
+
+/**
+ *  Access the decoder of the calling thread.
+ *  A thread processing blocks of the codec creates its decoder once,
+ *  before its first range, and reuses it for every following range of the batch.
+ *  Outside of a batch, a new decoder is created.
+ *  \param  create Function creating the decoder
+ */
+template <class Decoder, class Create>
+std::shared_ptr<Decoder> fec::Codec::workerDecoder(Create create) const
+{
+  auto cache = workerCache();
+  if (cache == nullptr) {
+    return std::shared_ptr<Decoder>(create());
   }
+  return cache->get<Decoder>(create);
 }
 
 template <typename Archive>
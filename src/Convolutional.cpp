@@ -50,12 +50,12 @@ const char * Convolutional::get_key() const
 
 void Convolutional::soDecodeBlocks(detail::Codec::InputIterator input, detail::Codec::OutputIterator output, size_t n) const
 {
-  auto worker = detail::MapDecoder::create(structure());
+  auto worker = workerDecoder<detail::MapDecoder>([&] {return detail::MapDecoder::create(structure());});
   worker->soDecodeBlocks(input, output, n);
 }
 
 void Convolutional::decodeBlocks(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, size_t n) const
 {
-  auto worker = detail::ViterbiDecoder::create(structure());
+  auto worker = workerDecoder<detail::ViterbiDecoder>([&] {return detail::ViterbiDecoder::create(structure());});
   worker->decodeBlocks(parity, msg, n);
 }
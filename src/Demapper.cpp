@@ -0,0 +1,219 @@
+/*******************************************************************************
+ This file is part of FeCl.
+ 
+ Copyright (c) 2015, Etienne Pierre-Doray, INRS
+ Copyright (c) 2015, Leszek Szczecinski, INRS
+ All rights reserved.
+ 
+ FeCl is free software: you can redistribute it and/or modify
+ it under the terms of the Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ FeCl is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the Lesser General Public License
+ along with FeCl.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#include "Demapper.h"
+#include "detail/LlrMetrics.h"
+
+using namespace fec;
+
+const size_t Demapper::laneCount_;
+
+namespace {
+  
+  const size_t maxLevelCount = 16;
+  
+  /**
+   *  Accumulates the metrics of the amplitudes whose label has a given bit at 0 and at 1.
+   *  \param  metric Metric of each amplitude, for each lane
+   *  \param  mask  Mask of the bit in the labels
+   */
+  template <class LogSumAlg, size_t LaneCount, typename std::enable_if<LogSumAlg::isRecursive::value>::type* = nullptr>
+  void bitMetrics(const double (&metric)[maxLevelCount][LaneCount], const std::vector<BitField<size_t>>& labels, size_t mask, size_t lanes, double (&result)[2][LaneCount])
+  {
+    for (size_t b = 0; b < 2; ++b) {
+      for (size_t l = 0; l < lanes; ++l) {
+        result[b][l] = -std::numeric_limits<double>::infinity();
+      }
+    }
+    for (size_t k = 0; k < labels.size(); ++k) {
+      auto& acc = result[(labels[k] & mask) != 0];
+      for (size_t l = 0; l < lanes; ++l) {
+        acc[l] = LogSumAlg::sum(acc[l], metric[k][l]);
+      }
+    }
+  }
+  
+  /**
+   *  Accumulates the metrics of the amplitudes whose label has a given bit at 0 and at 1.
+   *  The maximum metric of each bit value is found first,
+   *  and the metrics are summed relative to it.
+   */
+  template <class LogSumAlg, size_t LaneCount, typename std::enable_if<!LogSumAlg::isRecursive::value>::type* = nullptr>
+  void bitMetrics(const double (&metric)[maxLevelCount][LaneCount], const std::vector<BitField<size_t>>& labels, size_t mask, size_t lanes, double (&result)[2][LaneCount])
+  {
+    double max[2][LaneCount];
+    for (size_t b = 0; b < 2; ++b) {
+      for (size_t l = 0; l < lanes; ++l) {
+        max[b][l] = -std::numeric_limits<double>::infinity();
+        result[b][l] = 0.0;
+      }
+    }
+    for (size_t k = 0; k < labels.size(); ++k) {
+      auto& acc = max[(labels[k] & mask) != 0];
+      for (size_t l = 0; l < lanes; ++l) {
+        acc[l] = LogSumAlg::max(acc[l], metric[k][l]);
+      }
+    }
+    for (size_t k = 0; k < labels.size(); ++k) {
+      size_t b = (labels[k] & mask) != 0;
+      for (size_t l = 0; l < lanes; ++l) {
+        result[b][l] = LogSumAlg::sum(result[b][l], LogSumAlg::prior(metric[k][l], max[b][l]));
+      }
+    }
+    for (size_t b = 0; b < 2; ++b) {
+      for (size_t l = 0; l < lanes; ++l) {
+        result[b][l] = LogSumAlg::post(result[b][l], max[b][l]);
+      }
+    }
+  }
+
+}
+
+/**
+ *  Demapper constructor.
+ *  \param  modulation  Constellation of the symbols
+ *  \param  algorithm Algorithm used to compute L-values.
+ *    Approximate gives max-log L-values, Exact computes the log of sums of exponentials,
+ *    and Linear approximates the correction term with a lookup table.
+ */
+Demapper::Demapper(Modulation modulation, DecoderAlgorithm algorithm) : modulation_(modulation), algorithm_(algorithm)
+{
+  switch (modulation) {
+    case Bpsk:
+      dimensionCount_ = 1;
+      break;
+    
+    case Qpsk:
+    case Qam16:
+    case Qam64:
+    case Qam256:
+      dimensionCount_ = 2;
+      break;
+    
+    default:
+      throw std::invalid_argument("Invalid modulation");
+  }
+  dimensionBits_ = bitCount() / dimensionCount_;
+  
+  size_t levelCount = size_t(1) << dimensionBits_;
+  double energy = double(dimensionCount_) * (levelCount * levelCount - 1) / 3.0;
+  double scale = 1.0 / std::sqrt(energy);
+  levels_.resize(levelCount);
+  labels_.resize(levelCount);
+  for (size_t i = 0; i < levelCount; ++i) {
+    levels_[i] = scale * (2.0 * i + 1.0 - levelCount);
+    labels_[i] = i ^ (i >> 1);
+  }
+}
+
+/**
+ *  Computes the L-values of a sequence of symbols.
+ *  Symbols are processed by lanes of laneCount_ symbols,
+ *  and the L-values of a lane are written in the parity layout through the interleaver if there is one.
+ *  \param  symbols Pointer to the first symbol
+ *  \param  noiseVariance Pointer to the first noise variance
+ *  \param  noiseStride Distance between the noise variances of consecutive symbols, 0 if shared
+ *  \param  count Number of symbols
+ *  \param  interleaver Permutation from the parity to the transmitted bits, or nullptr
+ *  \param  llr[out] Pointer to the first L-value
+ */
+void Demapper::demapSymbols(const std::complex<float>* symbols, const float* noiseVariance, size_t noiseStride, size_t count, const Permutation* interleaver, double* llr) const
+{
+  double buffer[laneCount_ * 8];
+  size_t block = 0;
+  size_t bit = 0;
+  for (size_t i = 0; i < count; i += laneCount_) {
+    size_t lanes = std::min(laneCount_, count - i);
+    double* output = (interleaver == nullptr) ? llr + i * bitCount() : buffer;
+    switch (algorithm()) {
+      default:
+      case Approximate:
+        demapLanes<detail::MaxLogSum<detail::FloatLlrMetrics>>(symbols + i, noiseVariance + i * noiseStride, noiseStride, lanes, output);
+        break;
+      
+      case Linear:
+        demapLanes<detail::LinearLogSum<detail::FloatLlrMetrics>>(symbols + i, noiseVariance + i * noiseStride, noiseStride, lanes, output);
+        break;
+      
+      case Exact:
+        demapLanes<detail::LogSum<detail::FloatLlrMetrics>>(symbols + i, noiseVariance + i * noiseStride, noiseStride, lanes, output);
+        break;
+    }
+    
+    if (interleaver != nullptr) {
+      for (size_t j = 0; j < lanes * bitCount(); ++j) {
+        llr[block * interleaver->inputSize() + (*interleaver)[bit]] += buffer[j];
+        if (++bit == interleaver->outputSize()) {
+          bit = 0;
+          ++block;
+        }
+      }
+    }
+  }
+}
+
+/**
+ *  Computes the L-values of a lane of symbols.
+ *  Components are independent in a square constellation with Gray mapping,
+ *  such that the metric of each amplitude of a component is computed once
+ *  and shared by the bits of the component.
+ *  Loops run across the symbols of the lane, which the compiler can vectorize.
+ *  \param  symbols Pointer to the first symbol of the lane
+ *  \param  noiseVariance Pointer to the noise variance of the first symbol
+ *  \param  noiseStride Distance between the noise variances of consecutive symbols, 0 if shared
+ *  \param  lanes Number of symbols in the lane
+ *  \param  llr[out] Pointer to the first L-value of the lane
+ */
+template <class LogSumAlg>
+void Demapper::demapLanes(const std::complex<float>* symbols, const float* noiseVariance, size_t noiseStride, size_t lanes, double* llr) const
+{
+  double weight[laneCount_];
+  double y[laneCount_];
+  double metric[maxLevelCount][laneCount_];
+  double result[2][laneCount_];
+  
+  for (size_t l = 0; l < lanes; ++l) {
+    weight[l] = 1.0 / noiseVariance[l * noiseStride];
+  }
+  for (size_t d = 0; d < dimensionCount_; ++d) {
+    for (size_t l = 0; l < lanes; ++l) {
+      y[l] = (d == 0) ? symbols[l].real() : symbols[l].imag();
+    }
+    for (size_t k = 0; k < levels_.size(); ++k) {
+      for (size_t l = 0; l < lanes; ++l) {
+        double distance = y[l] - levels_[k];
+        metric[k][l] = -distance * distance * weight[l];
+      }
+    }
+    for (size_t t = 0; t < dimensionBits_; ++t) {
+      bitMetrics<LogSumAlg>(metric, labels_, size_t(1) << (dimensionBits_ - 1 - t), lanes, result);
+      size_t offset = t * dimensionCount_ + d;
+      for (size_t l = 0; l < lanes; ++l) {
+        llr[l * bitCount() + offset] = result[1][l] - result[0][l];
+      }
+    }
+  }
+}
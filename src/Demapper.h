@@ -0,0 +1,163 @@
+/*******************************************************************************
+ This file is part of FeCl.
+ 
+ Copyright (c) 2015, Etienne Pierre-Doray, INRS
+ Copyright (c) 2015, Leszek Szczecinski, INRS
+ All rights reserved.
+ 
+ FeCl is free software: you can redistribute it and/or modify
+ it under the terms of the Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ FeCl is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the Lesser General Public License
+ along with FeCl.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#ifndef FEC_DEMAPPER_H
+#define FEC_DEMAPPER_H
+
+#include <complex>
+#include <stdexcept>
+#include <vector>
+
+#include "BitField.h"
+#include "DecoderAlgorithm.h"
+#include "Permutation.h"
+
+namespace fec {
+
+/**
+ *  This class represents the soft demapper of a square constellation with Gray mapping.
+ *  The bits of a symbol alternate between the in-phase and the quadrature components,
+ *  the first bit of each component giving its sign.
+ *  A bit of value 1 is mapped to a positive amplitude,
+ *  such that the L-values follow the convention of the codecs.
+ *  Constellations are normalized to unit average energy.
+ */
+class Demapper {
+public:
+  /**
+   *  This enum lists the supported constellations.
+   *  The value of each constellation is its number of bits per symbol.
+   */
+  enum Modulation {
+    Bpsk = 1,
+    Qpsk = 2,
+    Qam16 = 4,
+    Qam64 = 6,
+    Qam256 = 8,
+  };
+  
+  Demapper(Modulation modulation, DecoderAlgorithm algorithm = Approximate);
+  
+  Modulation modulation() const {return modulation_;} /**< Access the constellation. */
+  DecoderAlgorithm algorithm() const {return algorithm_;} /**< Access the algorithm used to compute L-values. */
+  size_t bitCount() const {return size_t(modulation_);} /**< Access the number of bits per symbol. */
+  
+  template <template <typename> class A = std::allocator>
+  void map(const std::vector<BitField<size_t>,A<BitField<size_t>>>& bits, std::vector<std::complex<float>>& symbols) const;
+  
+  template <template <typename> class A = std::allocator>
+  void demap(const std::vector<std::complex<float>>& symbols, const std::vector<float>& noiseVariance, std::vector<double,A<double>>& llr) const;
+  template <template <typename> class A = std::allocator>
+  void demap(const std::vector<std::complex<float>>& symbols, const std::vector<float>& noiseVariance, const Permutation& interleaver, std::vector<double,A<double>>& llr) const;
+
+private:
+  void demapSymbols(const std::complex<float>* symbols, const float* noiseVariance, size_t noiseStride, size_t count, const Permutation* interleaver, double* llr) const;
+  template <class LogSumAlg>
+  void demapLanes(const std::complex<float>* symbols, const float* noiseVariance, size_t noiseStride, size_t lanes, double* llr) const;
+  
+  static const size_t laneCount_ = 16; /**< Number of symbols processed together by the kernels */
+  
+  Modulation modulation_;
+  DecoderAlgorithm algorithm_;
+  size_t dimensionCount_; /**< Number of components carrying bits */
+  size_t dimensionBits_; /**< Number of bits carried by each component */
+  std::vector<double> levels_; /**< Amplitudes of a component, in increasing order */
+  std::vector<BitField<size_t>> labels_; /**< Gray label of each amplitude, the first bit being the msb */
+};
+
+}
+
+/**
+ *  Maps bits to constellation symbols.
+ *  \param  bits  Vector containing the bits, whose size is a multiple of bitCount()
+ *  \param  symbols[out] Vector containing the symbols
+ */
+template <template <typename> class A>
+void fec::Demapper::map(const std::vector<BitField<size_t>,A<BitField<size_t>>>& bits, std::vector<std::complex<float>>& symbols) const
+{
+  size_t symbolCount = bits.size() / bitCount();
+  if (bits.size() != symbolCount * bitCount()) {
+    throw std::invalid_argument("Invalid size for bits");
+  }
+  
+  std::vector<size_t> amplitudes(labels_.size());
+  for (size_t i = 0; i < labels_.size(); ++i) {
+    amplitudes[labels_[i]] = i;
+  }
+  symbols.resize(symbolCount);
+  auto bit = bits.begin();
+  for (auto & symbol : symbols) {
+    size_t label[2] = {0, 0};
+    for (size_t t = 0; t < dimensionBits_; ++t) {
+      for (size_t d = 0; d < dimensionCount_; ++d) {
+        label[d] = (label[d] << 1) | size_t(*bit != 0);
+        ++bit;
+      }
+    }
+    symbol = std::complex<float>(float(levels_[amplitudes[label[0]]]), (dimensionCount_ > 1) ? float(levels_[amplitudes[label[1]]]) : 0.0f);
+  }
+}
+
+/**
+ *  Computes the L-values of the bits carried by symbols.
+ *  \param  symbols Vector containing the received symbols
+ *  \param  noiseVariance Vector containing the complex noise variance of each symbol,
+ *    or a single variance shared by every symbol
+ *  \param  llr[out] Vector containing the L-values, in the order of the bits in the symbols
+ */
+template <template <typename> class A>
+void fec::Demapper::demap(const std::vector<std::complex<float>>& symbols, const std::vector<float>& noiseVariance, std::vector<double,A<double>>& llr) const
+{
+  if (noiseVariance.size() != symbols.size() && noiseVariance.size() != 1) {
+    throw std::invalid_argument("Invalid size for noise variance");
+  }
+  
+  llr.resize(symbols.size() * bitCount());
+  demapSymbols(symbols.data(), noiseVariance.data(), noiseVariance.size() == 1 ? 0 : 1, symbols.size(), nullptr, llr.data());
+}
+
+/**
+ *  Computes the L-values of the bits carried by symbols, deinterleaved in the parity layout of a codec.
+ *  The symbols carry the permuted parity of several blocks.
+ *  Bits absent from the permutation are given a null L-value,
+ *  and L-values of repeated bits are combined.
+ *  \param  symbols Vector containing the received symbols
+ *  \param  noiseVariance Vector containing the complex noise variance of each symbol,
+ *    or a single variance shared by every symbol
+ *  \param  interleaver Permutation from the parity of a block to the transmitted bits.
+ *  \param  llr[out] Vector containing the L-values in the parity layout
+ */
+template <template <typename> class A>
+void fec::Demapper::demap(const std::vector<std::complex<float>>& symbols, const std::vector<float>& noiseVariance, const Permutation& interleaver, std::vector<double,A<double>>& llr) const
+{
+  if (noiseVariance.size() != symbols.size() && noiseVariance.size() != 1) {
+    throw std::invalid_argument("Invalid size for noise variance");
+  }
+  size_t blockCount = (interleaver.outputSize() > 0) ? symbols.size() * bitCount() / interleaver.outputSize() : 0;
+  if (blockCount * interleaver.outputSize() != symbols.size() * bitCount()) {
+    throw std::invalid_argument("Invalid size for symbols");
+  }
+  
+  llr.assign(blockCount * interleaver.inputSize(), 0.0);
+  demapSymbols(symbols.data(), noiseVariance.data(), noiseVariance.size() == 1 ? 0 : 1, symbols.size(), &interleaver, llr.data());
+}
+
+#endif
@@ -1617,29 +1617,21 @@ SparseBitMatrix Ldpc::DvbS2::matrix(size_t n, double rate)
   }
   
   size_t q = parameter_[lengthIdx][rateIdx];
-  size_t k = q * 360;
+  size_t m = q * 360;
+  size_t k = n - m;
+  auto& index = index_[lengthIdx][rateIdx];
   
-  std::vector<size_t> rowSizes(n);
+  SparseBitMatrix::Builder H(m, n);
+  H.reserve(k * index[0].size() + 2 * m);
   for (size_t i = 0; i < k; ++i) {
-    rowSizes[i] = index_[lengthIdx][rateIdx][i/360].size();
-  }
-  for (size_t i = n-k; i < n; ++i) {
-    rowSizes[i] = 2;
-  }
-  rowSizes[n-1] = 1;
-  
-  SparseBitMatrix H(rowSizes, n-k);
-  for (size_t i = 0; i < n-k; ++i) {
-    auto row = H[i];
-    for (size_t j = 0; j < index_[lengthIdx][rateIdx][i/360].size(); ++j) {
-      size_t col = ( index_[lengthIdx][rateIdx][i/360][j]+(i%360)*q ) % H.cols();
-      row.set(col);
+    for (size_t j = 0; j < index[i/360].size(); ++j) {
+      H.set((index[i/360][j] + (i%360)*q) % m, i);
     }
   }
-  for (size_t i = 0; i < k; ++i) {
-    for (size_t j = 0; j < 2 && j+i < H.cols(); ++j) {
-      H[i+n-k].set(i+j);
+  for (size_t i = 0; i < m; ++i) {
+    for (size_t j = 0; j < 2 && j+i < m; ++j) {
+      H.set(i+j, i+k);
     }
   }
-  return H.transpose();
+  return H.matrix();
 }
@@ -0,0 +1,341 @@
+/*******************************************************************************
+ This file is part of FeCl.
+ 
+ Copyright (c) 2015, Etienne Pierre-Doray, INRS
+ Copyright (c) 2015, Leszek Szczecinski, INRS
+ All rights reserved.
+ 
+ FeCl is free software: you can redistribute it and/or modify
+ it under the terms of the Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ FeCl is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the Lesser General Public License
+ along with FeCl.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <future>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "FileDecoder.h"
+
+using namespace fec;
+
+namespace {
+  
+  /**
+   *  Read-only view of a file.
+   *  The file is memory mapped where possible,
+   *  otherwise each range is read in a buffer.
+   */
+  class InputFile {
+  public:
+    InputFile(const std::string& path);
+    ~InputFile();
+    InputFile(const InputFile&) = delete;
+    InputFile& operator=(const InputFile&) = delete;
+    
+    size_t size() const {return size_;}
+    
+    const char* view(size_t offset, size_t size);
+    void prefetch(size_t offset, size_t size) const;
+    void release(size_t offset, size_t size) const;
+  
+  private:
+    size_t size_ = 0;
+#if defined(__unix__) || defined(__APPLE__)
+    int fd_ = -1;
+    char* data_ = nullptr;
+#else
+    std::ifstream file_;
+    std::vector<char> buffer_;
+#endif
+  };
+
+#if defined(__unix__) || defined(__APPLE__)
+  InputFile::InputFile(const std::string& path)
+  {
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    struct stat status;
+    if (fd_ == -1 || ::fstat(fd_, &status) != 0) {
+      if (fd_ != -1) {
+        ::close(fd_);
+      }
+      throw std::invalid_argument("Invalid llr file");
+    }
+    size_ = status.st_size;
+    if (size_ > 0) {
+      void* data = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+      if (data == MAP_FAILED) {
+        ::close(fd_);
+        throw std::invalid_argument("Invalid llr file");
+      }
+      data_ = static_cast<char*>(data);
+      ::madvise(data_, size_, MADV_SEQUENTIAL);
+    }
+  }
+  
+  InputFile::~InputFile()
+  {
+    if (data_ != nullptr) {
+      ::munmap(data_, size_);
+    }
+    ::close(fd_);
+  }
+  
+  /**
+   *  Access a range of the file.
+   *  The range needs to be within the file.
+   */
+  const char* InputFile::view(size_t offset, size_t size)
+  {
+    if (offset > size_ || size > size_ - offset) {
+      throw std::invalid_argument("Range past the end of the llr file");
+    }
+    return data_ + offset;
+  }
+  
+  /**
+   *  Asks the kernel to read a range ahead.
+   */
+  void InputFile::prefetch(size_t offset, size_t size) const
+  {
+    size_t page = ::sysconf(_SC_PAGESIZE);
+    size_t first = offset / page * page;
+    if (size > 0) {
+      ::madvise(data_ + first, offset + size - first, MADV_WILLNEED);
+    }
+  }
+  
+  /**
+   *  Drops the pages of a range which was consumed,
+   *  such that the mapping does not grow with the file.
+   *  Pages shared with the next range are kept.
+   */
+  void InputFile::release(size_t offset, size_t size) const
+  {
+    size_t page = ::sysconf(_SC_PAGESIZE);
+    size_t first = offset / page * page;
+    size_t last = (offset + size) / page * page;
+    if (last > first) {
+      ::madvise(data_ + first, last - first, MADV_DONTNEED);
+    }
+  }
+#else
+  InputFile::InputFile(const std::string& path) : file_(path, std::ios::binary)
+  {
+    if (!file_) {
+      throw std::invalid_argument("Invalid llr file");
+    }
+    file_.seekg(0, std::ios::end);
+    size_ = file_.tellg();
+  }
+  
+  InputFile::~InputFile() = default;
+  
+  /**
+   *  Reads a range of the file.
+   *  The range needs to be within the file.
+   */
+  const char* InputFile::view(size_t offset, size_t size)
+  {
+    if (offset > size_ || size > size_ - offset) {
+      throw std::invalid_argument("Range past the end of the llr file");
+    }
+    buffer_.resize(size);
+    file_.seekg(offset);
+    if (!file_.read(buffer_.data(), size)) {
+      throw std::invalid_argument("Invalid llr file");
+    }
+    return buffer_.data();
+  }
+  
+  void InputFile::prefetch(size_t, size_t) const {}
+  void InputFile::release(size_t, size_t) const {}
+#endif
+  
+  /**
+   *  Converts L-values of a given type to double.
+   */
+  template <typename T>
+  void convert(const char* input, size_t count, double scale, std::vector<double>& output)
+  {
+    output.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      T value;
+      std::memcpy(&value, input + i * sizeof(T), sizeof(T));
+      output[i] = scale * value;
+    }
+  }
+  
+  /**
+   *  Writes bits packed 8 per byte.
+   *  Bits left over by a write are kept for the next one.
+   */
+  class BitWriter {
+  public:
+    BitWriter(const std::string& path) : file_(path, std::ios::binary | std::ios::trunc)
+    {
+      if (!file_) {
+        throw std::invalid_argument("Invalid msg file");
+      }
+    }
+    
+    void write(const std::vector<BitField<size_t>>& bits)
+    {
+      buffer_.clear();
+      for (auto bit : bits) {
+        byte_ = (byte_ << 1) | uint8_t(bit != 0);
+        if (++bitCount_ == 8) {
+          buffer_.push_back(char(byte_));
+          byte_ = 0;
+          bitCount_ = 0;
+        }
+      }
+      file_.write(buffer_.data(), buffer_.size());
+    }
+    void flush()
+    {
+      if (bitCount_ > 0) {
+        char byte = char(byte_ << (8 - bitCount_));
+        file_.write(&byte, 1);
+        bitCount_ = 0;
+      }
+      file_.flush();
+      if (!file_) {
+        throw std::invalid_argument("Invalid msg file");
+      }
+    }
+  
+  private:
+    std::ofstream file_;
+    std::vector<char> buffer_;
+    uint8_t byte_ = 0;
+    size_t bitCount_ = 0;
+  };
+
+}
+
+/**
+ *  FileDecoder constructor.
+ *  \param  codec Codec used to decode, which must outlive the FileDecoder.
+ *    Its work group size sets the number of threads.
+ *  \param  options Format of the input and size of the chunks
+ */
+FileDecoder::FileDecoder(const Codec& codec, const Options& options) : codec_(codec), options_(options)
+{
+  if (options.format() != Double && options.format() != Float && options.format() != Int8) {
+    throw std::invalid_argument("Invalid format");
+  }
+}
+
+/**
+ *  Decodes a file of parity L-values.
+ *  \param  llrPath Path of the file containing the L-values of a whole number of blocks
+ *  \param  msgPath Path of the file receiving the packed msg bits, which is overwritten
+ *  \return Number of blocks decoded
+ */
+size_t FileDecoder::decode(const std::string& llrPath, const std::string& msgPath) const
+{
+  InputFile input(llrPath);
+  size_t blockBytes = codec_.paritySize() * elementSize();
+  size_t blockCount = input.size() / blockBytes;
+  if (blockCount * blockBytes != input.size()) {
+    throw std::invalid_argument("Invalid size for llr file");
+  }
+  BitWriter output(msgPath);
+  
+  size_t chunkSize = chunkBlocks();
+  size_t chunkCount = (blockCount + chunkSize - 1) / chunkSize;
+  auto read = [&](size_t chunk, std::vector<double>& parity) {
+    size_t first = chunk * chunkSize * blockBytes;
+    size_t size = std::min(chunkSize, blockCount - chunk * chunkSize) * blockBytes;
+    if (chunk + 1 < chunkCount) {
+      input.prefetch(first + size, std::min(chunkSize * blockBytes, input.size() - first - size));
+    }
+    const char* data = input.view(first, size);
+    switch (options_.format()) {
+      case Double:
+        convert<double>(data, size / sizeof(double), options_.scale(), parity);
+        break;
+      
+      case Float:
+        convert<float>(data, size / sizeof(float), options_.scale(), parity);
+        break;
+      
+      case Int8:
+        convert<int8_t>(data, size, options_.scale(), parity);
+        break;
+    }
+    input.release(first, size);
+  };
+  
+  std::vector<double> parity[2];
+  std::vector<BitField<size_t>> msg[2];
+  std::future<void> reading;
+  std::future<void> writing;
+  if (chunkCount > 0) {
+    reading = std::async(std::launch::async, read, 0, std::ref(parity[0]));
+  }
+  for (size_t i = 0; i < chunkCount; ++i) {
+    reading.get();
+    if (i + 1 < chunkCount) {
+      reading = std::async(std::launch::async, read, i + 1, std::ref(parity[(i+1) % 2]));
+    }
+    codec_.decode(parity[i % 2], msg[i % 2]);
+    if (writing.valid()) {
+      writing.get();
+    }
+    writing = std::async(std::launch::async, &BitWriter::write, &output, std::cref(msg[i % 2]));
+  }
+  if (writing.valid()) {
+    writing.get();
+  }
+  output.flush();
+  return blockCount;
+}
+
+/**
+ *  Computes the number of blocks in a chunk.
+ */
+size_t FileDecoder::chunkBlocks() const
+{
+  if (options_.chunkSize() > 0) {
+    return options_.chunkSize();
+  }
+  const size_t chunkBytes = size_t(1) << 24;
+  return std::max(chunkBytes / (codec_.paritySize() * sizeof(double)), size_t(1));
+}
+
+/**
+ *  Access the size of an L-value in the input file.
+ */
+size_t FileDecoder::elementSize() const
+{
+  switch (options_.format()) {
+    case Double:
+      return sizeof(double);
+    
+    case Float:
+      return sizeof(float);
+    
+    default:
+    case Int8:
+      return sizeof(int8_t);
+  }
+}
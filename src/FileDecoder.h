@@ -0,0 +1,86 @@
+/*******************************************************************************
+ This file is part of FeCl.
+ 
+ Copyright (c) 2015, Etienne Pierre-Doray, INRS
+ Copyright (c) 2015, Leszek Szczecinski, INRS
+ All rights reserved.
+ 
+ FeCl is free software: you can redistribute it and/or modify
+ it under the terms of the Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ FeCl is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the Lesser General Public License
+ along with FeCl.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#ifndef FEC_FILE_DECODER_H
+#define FEC_FILE_DECODER_H
+
+#include <stdexcept>
+#include <string>
+
+#include "Codec.h"
+
+namespace fec {
+
+/**
+ *  This class decodes a file of parity L-values into a file of msg bits.
+ *  The input file is memory mapped and streamed through the codec in chunks of blocks,
+ *  such that memory use does not depend on the size of the file.
+ *  The next chunk is read and converted while the current one is decoded,
+ *  and the previous one is written.
+ *  Decoded bits are packed 8 per byte, the first bit in the most significant position.
+ */
+class FileDecoder {
+public:
+  /**
+   *  This enum lists the types of the L-values in the input file, in native byte order.
+   */
+  enum Format {
+    Double,
+    Float,
+    Int8,
+  };
+  
+  struct Options {
+  public:
+    Options() = default;
+    
+    Options& format(Format format) {format_ = format; return *this;}
+    Options& scale(double scale) {scale_ = scale; return *this;}
+    Options& chunkSize(size_t blockCount) {chunkSize_ = blockCount; return *this;}
+    
+    Format format() const {return format_;} /**< Access the type of the L-values. */
+    double scale() const {return scale_;} /**< Access the factor applied to the L-values read. */
+    size_t chunkSize() const {return chunkSize_;} /**< Access the number of blocks decoded together, 0 for a chunk of about 16 MB. */
+  
+  private:
+    Format format_ = Float;
+    double scale_ = 1.0;
+    size_t chunkSize_ = 0;
+  };
+  
+  FileDecoder(const Codec& codec) : FileDecoder(codec, Options()) {}
+  FileDecoder(const Codec& codec, const Options& options);
+  
+  const Options& options() const {return options_;} /**< Access the options. */
+  
+  size_t decode(const std::string& llrPath, const std::string& msgPath) const;
+
+private:
+  size_t chunkBlocks() const;
+  size_t elementSize() const;
+  
+  const Codec& codec_;
+  Options options_;
+};
+
+}
+
+#endif
@@ -0,0 +1,125 @@
+/*******************************************************************************
+ This file is part of FeCl.
+ 
+ Copyright (c) 2015, Etienne Pierre-Doray, INRS
+ Copyright (c) 2015, Leszek Szczecinski, INRS
+ All rights reserved.
+ 
+ FeCl is free software: you can redistribute it and/or modify
+ it under the terms of the Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ FeCl is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the Lesser General Public License
+ along with FeCl.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#ifndef FEC_HARQ_BUFFER_H
+#define FEC_HARQ_BUFFER_H
+
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "Permutation.h"
+
+namespace fec {
+
+/**
+ *  This class represents the soft buffer of a HARQ process.
+ *  L-values received at each (re)transmission are combined in place
+ *  in a fixed point representation with saturation.
+ *  The buffer has the parity layout of the codec and can be used as decoder input.
+ *  \tparam T Storage type, typically int8_t or int16_t
+ */
+template <typename T>
+class HarqBuffer {
+public:
+  HarqBuffer() = default;
+  /**
+   *  HarqBuffer constructor.
+   *  \param  size  Size of the buffer. This is the parity size times the number of blocks.
+   *  \param  scale Scaling applied to L-values before quantization.
+   */
+  HarqBuffer(size_t size, double scale = 1.0) {buffer_.resize(size, 0); scale_ = scale;}
+  
+  size_t size() const {return buffer_.size();} /**< Access the size of the buffer. */
+  double scale() const {return scale_;} /**< Access the quantization scaling. */
+  const std::vector<T>& data() const {return buffer_;} /**< Access the quantized L-values. */
+  
+  void clear() {std::fill(buffer_.begin(), buffer_.end(), 0);} /**< Flush the buffer for a new transmission. */
+  
+  template <template <typename> class A = std::allocator>
+  void combine(const std::vector<double,A<double>>& llr, const Permutation& rateMatching);
+  
+  template <template <typename> class A = std::allocator>
+  void llr(std::vector<double,A<double>>& llr) const;
+  std::vector<double> llr() const;
+  
+private:
+  static int32_t saturate(int32_t x) {return std::max(std::min(x, max()), -max());}
+  static int32_t max() {return std::numeric_limits<T>::max();}
+  
+  std::vector<T> buffer_;
+  double scale_ = 1.0;
+};
+
+}
+
+/**
+ *  Soft combines received L-values in the buffer.
+ *  Each L-value is accumulated at the parity index given by the rate matching.
+ *  Repeated bits are combined as well.
+ *  \param  llr Vector containing received L-values for each block
+ *  \param  rateMatching  Permutation from the parity to the received bits.
+ */
+template <typename T>
+template <template <typename> class A>
+void fec::HarqBuffer<T>::combine(const std::vector<double,A<double>>& llr, const Permutation& rateMatching)
+{
+  size_t blockCount = llr.size() / rateMatching.outputSize();
+  if (llr.size() != blockCount * rateMatching.outputSize() || blockCount * rateMatching.inputSize() != size()) {
+    throw std::invalid_argument("Invalid size for llr");
+  }
+  
+  auto llrIt = llr.begin();
+  for (auto block = buffer_.begin(); block < buffer_.end(); block += rateMatching.inputSize()) {
+    for (size_t i = 0; i < rateMatching.outputSize(); ++i) {
+      double x = std::max(std::min(llrIt[i] * scale(), double(max())), -double(max()));
+      auto& y = block[rateMatching[i]];
+      y = saturate(int32_t(y) + int32_t(std::lround(x)));
+    }
+    llrIt += rateMatching.outputSize();
+  }
+}
+
+/**
+ *  Access the combined L-values.
+ *  \param  llr[out] Vector containing the combined L-values in the parity layout of the codec
+ */
+template <typename T>
+template <template <typename> class A>
+void fec::HarqBuffer<T>::llr(std::vector<double,A<double>>& llr) const
+{
+  llr.resize(size());
+  for (size_t i = 0; i < size(); ++i) {
+    llr[i] = buffer_[i] / scale();
+  }
+}
+
+template <typename T>
+std::vector<double> fec::HarqBuffer<T>::llr() const
+{
+  std::vector<double> output;
+  llr(output);
+  return output;
+}
+
+#endif
@@ -46,18 +46,34 @@ const char * Ldpc::get_key() const {
   return boost::serialization::type_info_implementation<Ldpc>::type::get_const_instance().get_key();
 }
 
+void Ldpc::checkBlocks(std::vector<BitField<size_t>>::const_iterator parity, std::vector<BitField<size_t>>::iterator result, size_t n) const
+{
+  structure().checkEach(parity, result, n);
+}
+
+void Ldpc::syndromeBlocks(std::vector<BitField<size_t>>::const_iterator parity, std::vector<BitField<size_t>>::iterator syndrome, size_t n) const
+{
+  structure().syndrome(parity, syndrome, n);
+}
+
 void Ldpc::soDecodeBlocks(detail::Codec::InputIterator input, detail::Codec::OutputIterator output, size_t n) const
 {
-  auto worker = detail::BpDecoder::create(structure());
+  auto worker = workerDecoder<detail::BpDecoder>([&] {return detail::BpDecoder::create(structure());});
   worker->soDecodeBlocks(input, output, n);
 }
 
 void Ldpc::decodeBlocks(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, size_t n) const
 {
-  auto worker = detail::BpDecoder::create(structure());
+  auto worker = workerDecoder<detail::BpDecoder>([&] {return detail::BpDecoder::create(structure());});
   worker->decodeBlocks(parity, msg, n);
 }
 
+void Ldpc::timedDecodeBlocks(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, std::vector<BitField<size_t>>::iterator converged, size_t n, detail::Codec::Deadline& deadline) const
+{
+  auto worker = workerDecoder<detail::BpDecoder>([&] {return detail::BpDecoder::create(structure());});
+  worker->decodeBlocks(parity, msg, converged, n, deadline);
+}
+
 /**
  *  Create a random ldpc matrix using gallager construction method.
  *  This matrix describes a regular ldpc code with n parity.
@@ -76,28 +92,47 @@ void Ldpc::decodeBlocks(std::vector<double>::const_iterator parity, std::vector<
  */
 SparseBitMatrix Ldpc::Gallager::matrix(size_t n, size_t wc, size_t wr, uint64_t seed)
 {
-  SparseBitMatrix H(n/wr * wc, n, wr);
+  size_t bandSize = n/wr;
+  SparseBitMatrix::Builder H(bandSize * wc, n);
+  H.reserve(bandSize * wc * wr);
   
   size_t elem = 0;
-  auto row = H.begin();
-  for (size_t i = 0; i < n/wr; i++) {
+  for (size_t i = 0; i < bandSize; i++) {
     for (size_t j = 0; j < wr; j++) {
-      for (size_t k = 0; k < H.rows(); k+=n/wr) {
-        row[k].set(elem);
+      for (size_t k = 0; k < H.rows(); k+=bandSize) {
+        H.set(i+k, elem);
       }
       elem++;
     }
-    ++row;
   }
   
+  /*
+   *  Columns of each band are swapped by tracking the position of each column,
+   *  and the resulting permutations are applied once the matrix is built.
+   */
+  std::vector<std::vector<size_t>> colPos(wc, std::vector<size_t>(n));
+  std::vector<std::vector<size_t>> colIdx(wc, std::vector<size_t>(n));
+  for (size_t k = 0; k < wc; ++k) {
+    for (size_t j = 0; j < n; ++j) {
+      colPos[k][j] = j;
+      colIdx[k][j] = j;
+    }
+  }
   std::minstd_rand0 generator((int)seed);
   for (size_t j = 0; j < H.cols(); j++) {
     std::uniform_int_distribution<int> distribution(int(j),int(H.cols()-1));
-    for (size_t i = n/wr; i < H.rows(); i+=n/wr) {
-      H.swapCols(j, distribution(generator), {i, i+n/wr});
+    for (size_t k = 1; k < wc; ++k) {
+      size_t a = j;
+      size_t b = distribution(generator);
+      std::swap(colIdx[k][a], colIdx[k][b]);
+      colPos[k][colIdx[k][a]] = a;
+      colPos[k][colIdx[k][b]] = b;
     }
   }
+  for (size_t k = 1; k < wc; ++k) {
+    H.permuteCols(colPos[k], {k*bandSize, (k+1)*bandSize});
+  }
   
-  return H;
+  return H.matrix();
 }
 
@@ -92,6 +92,12 @@ namespace fec {
     DecoderOptions getDecoderOptions() const {return structure().getDecoderOptions();}
     
     Permutation puncturing(const PunctureOptions& options) {return structure().puncturing(options);}
+    BitMatrix generatorMatrix() const {return structure().generatorMatrix();}
+    
+    template <template <typename> class A>
+    void syndromes(const std::vector<BitField<size_t>,A<BitField<size_t>>>& parity, std::vector<BitField<size_t>,A<BitField<size_t>>>& syndrome) const;
+    template <template <typename> class A>
+    std::vector<BitField<size_t>,A<BitField<size_t>>> syndromes(const std::vector<BitField<size_t>,A<BitField<size_t>>>& parity) const;
     
   protected:
     Ldpc(std::unique_ptr<detail::Ldpc::Structure>&& structure, int workGroupSize = 4) : Codec(std::move(structure), workGroupSize) {}
@@ -99,10 +105,14 @@ namespace fec {
     inline const detail::Ldpc::Structure& structure() const {return dynamic_cast<const detail::Ldpc::Structure&>(Codec::structure());}
     inline detail::Ldpc::Structure& structure() {return dynamic_cast<detail::Ldpc::Structure&>(Codec::structure());}
     
+    virtual void checkBlocks(std::vector<BitField<size_t>>::const_iterator parity, std::vector<BitField<size_t>>::iterator result, size_t n) const;
     virtual void decodeBlocks(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, size_t n) const;
     virtual void soDecodeBlocks(detail::Codec::InputIterator input, detail::Codec::OutputIterator output, size_t n) const;
+    virtual void timedDecodeBlocks(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, std::vector<BitField<size_t>>::iterator converged, size_t n, detail::Codec::Deadline& deadline) const;
     
   private:
+    void syndromeBlocks(std::vector<BitField<size_t>>::const_iterator parity, std::vector<BitField<size_t>>::iterator syndrome, size_t n) const;
+    
     template <typename Archive>
     void serialize(Archive & ar, const unsigned int version);
   };
@@ -113,6 +123,43 @@ BOOST_CLASS_EXPORT_KEY(fec::Ldpc);
 BOOST_CLASS_TYPE_INFO(fec::Ldpc,extended_type_info_no_rtti<fec::Ldpc>);
 
 
+template <template <typename> class A>
+std::vector<fec::BitField<size_t>,A<fec::BitField<size_t>>> fec::Ldpc::syndromes(const std::vector<fec::BitField<size_t>,A<fec::BitField<size_t>>>& parity) const
+{
+  std::vector<fec::BitField<size_t>,A<fec::BitField<size_t>>> syndrome;
+  syndromes(parity, syndrome);
+  return syndrome;
+}
+
+/**
+ *  Computes the syndrome of several blocks of parity bits.
+ *  Chunks of blocs are processed in parallel.
+ *  \param  parity  Vector containing parity bits
+ *  \param  syndrome[out] Vector containing the syndrome of each block,
+ *    with one element per check
+ *  \tparam A Container allocator. The reason for different allocator is to allow
+ *    the matlab API to use a custom mex allocator
+ */
+template <template <typename> class A>
+void fec::Ldpc::syndromes(const std::vector<BitField<size_t>,A<BitField<size_t>>>& parity, std::vector<BitField<size_t>,A<BitField<size_t>>>& syndrome) const
+{
+  uint64_t blockCount = parity.size() / (paritySize());
+  if (parity.size() != blockCount * paritySize()) {
+    throw std::invalid_argument("Invalid size for parity");
+  }
+  
+  size_t checkCount = structure().checks().rows();
+  syndrome.resize(blockCount * checkCount, 0);
+  if (blockCount == 0) {
+    return;
+  }
+  auto parityIt = parity.begin(); auto syndromeIt = syndrome.begin();
+  
+  runBlocks(blockCount, (paritySize() + checkCount) * sizeof(BitField<size_t>), [&](size_t first, size_t n) {
+    syndromeBlocks(parityIt + paritySize() * first, syndromeIt + checkCount * first, n);
+  }, parity.data(), paritySize() * sizeof(BitField<size_t>));
+}
+
 template <typename Archive>
 void fec::Ldpc::serialize(Archive & ar, const unsigned int version) {
   using namespace boost::serialization;
@@ -23,6 +23,10 @@
 
 using namespace fec;
 
+const size_t Turbo::Lte3Gpp::columnCount_;
+
+const std::array<size_t, Turbo::Lte3Gpp::columnCount_> Turbo::Lte3Gpp::columnPermutation_ = {0, 16, 8, 24, 4, 20, 12, 28, 2, 18, 10, 26, 6, 22, 14, 30, 1, 17, 9, 25, 5, 21, 13, 29, 3, 19, 11, 27, 7, 23, 15, 31};
+
 const std::array<size_t, 188> Turbo::Lte3Gpp::length_ = {40, 48, 56, 64, 72, 80, 88, 96, 104, 112, 120, 128, 136, 144, 152, 160, 168, 176, 184, 192, 200, 208, 216, 224, 232, 240, 248, 256, 264, 272, 280, 288, 296, 304, 312, 320, 328, 336, 344, 352, 360, 368, 376, 384, 392, 400, 408, 416, 424, 432, 440, 448, 456, 464, 472, 480, 488, 496, 504, 512, 528, 544, 560, 576, 592, 608, 624, 640, 656, 672, 688, 704, 720, 736, 752, 768, 784, 800, 816, 832, 848, 864, 880, 896, 912, 928, 944, 960, 976, 992, 1008, 1024, 1056, 1088, 1120, 1152, 1184, 1216, 1248, 1280, 1312, 1344, 1376, 1408, 1440, 1472, 1504, 1536, 1568, 1600, 1632, 1664, 1696, 1728, 1760, 1792, 1824, 1856, 1888, 1920, 1952, 1984, 2016, 2048, 2112, 2176, 2240, 2304, 2368, 2432, 2496, 2560, 2624, 2688, 2752, 2816, 2880, 2944, 3008, 3072, 3136, 3200, 3264, 3328, 3392, 3456, 3520, 3584, 3648, 3712, 3776, 3840, 3904, 3968, 4032, 4096, 4160, 4224, 4288, 4352, 4416, 4480, 4544, 4608, 4672, 4736, 4800, 4864, 4928, 4992, 5056, 5120, 5184, 5248, 5312, 5376, 5440, 5504, 5568, 5632, 5696, 5760, 5824, 5888, 5952, 6016, 6080, 6144};
 
 const std::vector<std::vector<size_t>> Turbo::Lte3Gpp::parameter_ = {
@@ -229,11 +233,87 @@ Permutation Turbo::Lte3Gpp::interleaver(size_t length)
     throw std::invalid_argument("Invalid length");
   }
   
-  std::vector<size_t> perm(length_[lengthIdx]);
-  for (size_t i = 0; i < perm.size(); ++i) {
-    perm[i] = (parameter_[lengthIdx][0] * i + parameter_[lengthIdx][1] * (i*i)) % perm.size();
-  }
-  return Permutation(perm);
+  return Permutation::qpp(length, parameter_[lengthIdx][0], parameter_[lengthIdx][1]);
 }
 
-
+Permutation Turbo::Lte3Gpp::rateMatching(const Turbo& codec, size_t outputSize, size_t redundancyVersion, size_t softBufferSize)
+{
+  const auto& structure = codec.structure();
+  if (structure.constituentCount() != 2) {
+    throw std::invalid_argument("Invalid constituent count for rate matching");
+  }
+  for (size_t i = 0; i < structure.constituentCount(); ++i) {
+    if (structure.constituent(i).trellis().inputSize() != 1 || structure.constituent(i).trellis().outputSize() != 1) {
+      throw std::invalid_argument("Invalid trellis for rate matching");
+    }
+    if (structure.constituent(i).length() != structure.msgSize() || structure.constituent(i).tailSize() != structure.constituent(0).tailSize()) {
+      throw std::invalid_argument("Invalid constituent for rate matching");
+    }
+  }
+  if (redundancyVersion > 3) {
+    throw std::invalid_argument("Invalid redundancy version");
+  }
+  size_t tailSize = structure.constituent(0).tailSize();
+  if ((tailSize * 4) % 3 != 0) {
+    throw std::invalid_argument("Invalid tail size for rate matching");
+  }
+  
+  const size_t null = structure.paritySize();
+  
+  // Bit streams d0, d1 and d2 as index in the parity. Tail bits are distributed
+  // as x_K z_K x_K+1 z_K+1 ... for each constituent alternatively in each stream.
+  std::vector<std::vector<size_t>> stream(3);
+  size_t parityIdx = structure.systSize();
+  for (size_t i = 0; i < structure.msgSize(); ++i) {
+    stream[0].push_back(i);
+    stream[1].push_back(parityIdx + i);
+    stream[2].push_back(parityIdx + structure.constituent(0).paritySize() + i);
+  }
+  size_t streamIdx = 0;
+  size_t systTailIdx = structure.msgSize();
+  for (size_t i = 0; i < structure.constituentCount(); ++i) {
+    for (size_t j = 0; j < tailSize; ++j) {
+      stream[streamIdx++ % 3].push_back(systTailIdx + j);
+      stream[streamIdx++ % 3].push_back(parityIdx + structure.msgSize() + j);
+    }
+    systTailIdx += structure.constituent(i).systTailSize();
+    parityIdx += structure.constituent(i).paritySize();
+  }
+  
+  size_t streamSize = stream[0].size();
+  size_t rowCount = (streamSize + columnCount_ - 1) / columnCount_;
+  size_t interleaverSize = rowCount * columnCount_;
+  size_t nullCount = interleaverSize - streamSize;
+  
+  std::vector<size_t> circularBuffer(3 * interleaverSize, null);
+  for (size_t i = 0; i < interleaverSize; ++i) {
+    size_t idx = columnPermutation_[i / rowCount] + columnCount_ * (i % rowCount);
+    size_t shiftedIdx = (idx + 1) % interleaverSize;
+    if (idx >= nullCount) {
+      circularBuffer[i] = stream[0][idx - nullCount];
+      circularBuffer[interleaverSize + 2*i] = stream[1][idx - nullCount];
+    }
+    if (shiftedIdx >= nullCount) {
+      circularBuffer[interleaverSize + 2*i + 1] = stream[2][shiftedIdx - nullCount];
+    }
+  }
+  
+  size_t bufferSize = circularBuffer.size();
+  if (softBufferSize != 0 && softBufferSize < bufferSize) {
+    bufferSize = softBufferSize;
+  }
+  if (std::count(circularBuffer.begin(), circularBuffer.begin() + bufferSize, null) == ptrdiff_t(bufferSize)) {
+    throw std::invalid_argument("Invalid soft buffer size");
+  }
+  
+  size_t k0 = rowCount * (2 * ((bufferSize + 8*rowCount - 1) / (8*rowCount)) * redundancyVersion + 2);
+  std::vector<size_t> perm;
+  perm.reserve(outputSize);
+  for (size_t j = 0; perm.size() < outputSize; ++j) {
+    size_t idx = circularBuffer[(k0 + j) % bufferSize];
+    if (idx != null) {
+      perm.push_back(idx);
+    }
+  }
+  return Permutation(perm, structure.paritySize());
+}
@@ -0,0 +1,73 @@
+/*******************************************************************************
+ This file is part of FeCl.
+ 
+ Copyright (c) 2015, Etienne Pierre-Doray, INRS
+ Copyright (c) 2015, Leszek Szczecinski, INRS
+ All rights reserved.
+ 
+ FeCl is free software: you can redistribute it and/or modify
+ it under the terms of the Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ FeCl is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the Lesser General Public License
+ along with FeCl.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include "MemoryPool.h"
+#include "detail/Arena.h"
+
+using namespace fec;
+
+/**
+ *  MemoryPool constructor.
+ *  Arenas are mapped when they are first needed.
+ *  \param  options Size and backing of the arenas
+ */
+MemoryPool::MemoryPool(const Options& options) : options_(options)
+{
+}
+
+MemoryPool::~MemoryPool() = default;
+
+/**
+ *  Access the number of arenas mapped by the pool,
+ *  which is the largest number of threads it served at once.
+ */
+size_t MemoryPool::arenaCount() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return arenas_.size();
+}
+
+/**
+ *  Takes an arena from the pool, mapping a new one if every arena is in use.
+ *  \return Arena for the exclusive use of the caller until it is released
+ */
+detail::Arena* MemoryPool::acquire()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (available_.empty()) {
+    arenas_.push_back(std::unique_ptr<detail::Arena>(new detail::Arena(options_.arenaSize(), options_.hugePages(), options_.lock())));
+    return arenas_.back().get();
+  }
+  auto arena = available_.back();
+  available_.pop_back();
+  return arena;
+}
+
+/**
+ *  Returns an arena to the pool.
+ *  \param  arena Arena given by acquire
+ */
+void MemoryPool::release(detail::Arena* arena)
+{
+  arena->reset();
+  std::lock_guard<std::mutex> lock(mutex_);
+  available_.push_back(arena);
+}
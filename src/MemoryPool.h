@@ -0,0 +1,85 @@
+/*******************************************************************************
+ This file is part of FeCl.
+ 
+ Copyright (c) 2015, Etienne Pierre-Doray, INRS
+ Copyright (c) 2015, Leszek Szczecinski, INRS
+ All rights reserved.
+ 
+ FeCl is free software: you can redistribute it and/or modify
+ it under the terms of the Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ FeCl is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the Lesser General Public License
+ along with FeCl.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#ifndef FEC_MEMORY_POOL_H
+#define FEC_MEMORY_POOL_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace fec {
+  
+  namespace detail {
+    class Arena;
+  }
+  
+  /**
+   *  This class holds the memory in which codecs allocate the workspaces of their decoders.
+   *  Each thread processing blocks takes an arena from the pool and returns it when the batch is done,
+   *  such that arenas are mapped once and reused by the following batches.
+   *  Workspaces are aligned on cache lines.
+   *  A pool can be shared by several codecs, and is set on a codec with Codec::setMemoryPool.
+   */
+  class MemoryPool {
+  public:
+    struct Options {
+    public:
+      Options() = default;
+      
+      Options& arenaSize(size_t bytes) {arenaSize_ = bytes; return *this;}
+      Options& hugePages(bool hugePages) {hugePages_ = hugePages; return *this;}
+      Options& lock(bool lock) {lock_ = lock; return *this;}
+      
+      size_t arenaSize() const {return arenaSize_;} /**< Access the size of the arena of each thread, in bytes. Workspaces which do not fit come from the heap. */
+      bool hugePages() const {return hugePages_;} /**< Access wether arenas are backed by huge pages, reducing TLB misses on large codes. */
+      bool lock() const {return lock_;} /**< Access wether arenas are locked in memory for real-time use. This may require privileges. */
+    
+    private:
+      size_t arenaSize_ = size_t(1) << 25;
+      bool hugePages_ = false;
+      bool lock_ = false;
+    };
+    
+    MemoryPool() : MemoryPool(Options()) {}
+    MemoryPool(const Options& options);
+    ~MemoryPool();
+    
+    MemoryPool(const MemoryPool&) = delete;
+    MemoryPool& operator=(const MemoryPool&) = delete;
+    
+    const Options& options() const {return options_;} /**< Access the options. */
+    size_t arenaCount() const;
+    
+    detail::Arena* acquire();
+    void release(detail::Arena* arena);
+  
+  private:
+    Options options_;
+    
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<detail::Arena>> arenas_;
+    std::vector<detail::Arena*> available_;
+  };
+
+}
+
+#endif
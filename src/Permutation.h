@@ -24,10 +24,14 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
 #include <vector>
 #include <boost/serialization/nvp.hpp>
 #include <boost/serialization/utility.hpp>
 #include <boost/serialization/vector.hpp>
+#include <boost/serialization/version.hpp>
 
 namespace fec {
 
@@ -37,10 +41,26 @@ namespace fec {
   * is picked at a specific index from the input sequence. 
   * The index is defined by the index sequence given at the construction.
   * The permutation can permute many independant sequences at once.
+  *
+  * Index sequences are stored with the narrowest index type that fits the input size.
+  * Permutations following a known pattern are not stored at all and indices
+  * are generated on the fly.
   */
 class Permutation {
   friend class boost::serialization::access;
 public:
+  /**
+   *  Permutation types.
+   *  This defines how the index sequence is stored or generated.
+   */
+  enum Type {
+    Table, /**< The index sequence is stored explicitly. */
+    Identity, /**< Each output element is picked at the same index. */
+    Qpp, /**< Quadratic permutation polynomial (f1*i + f2*i^2) mod length. */
+    Periodic, /**< Elements are picked according to a periodic mask. */
+    Block, /**< Elements are written row by row and read column by column. */
+  };
+  
   Permutation() = default;
   /**
    * Permutation constructor.
@@ -52,8 +72,7 @@ public:
     if (sequence.size() == 0) {
       return;
     }
-    sequence_ = sequence;
-    inputSize_ = *std::max_element(sequence_.begin(), sequence_.end()) + 1;
+    setSequence(sequence, *std::max_element(sequence.begin(), sequence.end()) + 1);
   }
   /**
    * Permutation constructor.
@@ -64,14 +83,19 @@ public:
    *  \param  inputSize Length of the input sequence for interleaving.
    */
   Permutation(::std::vector<size_t> sequence, size_t inputSize) {
-    sequence_ = sequence;
-    inputSize_ = inputSize;
+    setSequence(sequence, inputSize);
   }
   
+  static Permutation identity(size_t length);
+  static Permutation qpp(size_t length, size_t f1, size_t f2);
+  static Permutation periodic(const std::vector<bool>& mask, size_t inputSize);
+  static Permutation block(size_t rowCount, size_t colCount);
+  
+  Type type() const {return type_;}
   size_t inputSize() const {return inputSize_;}
-  size_t outputSize() const {return sequence_.size();}
+  size_t outputSize() const {return outputSize_;}
   
-  size_t operator[] (size_t i) const {return sequence_[i];}
+  size_t operator[] (size_t i) const;
   
   template <typename T1, typename T2=T1> void permute(const std::vector<T1>& input, std::vector<T2>& output) const;
   template <typename T1, typename T2=T1> void dePermute(const std::vector<T1>& input, std::vector<T2>& output) const;
@@ -89,20 +113,225 @@ public:
   template <typename T1, typename T2=T1>
   void dePermuteBlock(typename std::vector<T1>::const_iterator input, typename std::vector<T2>::iterator output) const;
   
+  /**
+   *  Calls a function for each element of the permutation, in output order.
+   *  \param  f Function called with the output index and the corresponding input index.
+   */
+  template <class F> void forEach(F f) const;
+  
 private:
   template <typename Archive>
   void serialize(Archive & ar, const unsigned int version) {
     using namespace boost::serialization;
+    if (version == 0) {
+      std::vector<size_t> sequence;
+      ar & make_nvp("sequence_", sequence);
+      ar & BOOST_SERIALIZATION_NVP(inputSize_);
+      setSequence(sequence, inputSize_);
+      return;
+    }
+    ar & BOOST_SERIALIZATION_NVP(type_);
+    ar & BOOST_SERIALIZATION_NVP(shortSequence_);
     ar & BOOST_SERIALIZATION_NVP(sequence_);
+    ar & BOOST_SERIALIZATION_NVP(parameter_);
     ar & BOOST_SERIALIZATION_NVP(inputSize_);
+    ar & BOOST_SERIALIZATION_NVP(outputSize_);
   }
   
-  std::vector<size_t> sequence_;
+  void setSequence(const std::vector<size_t>& sequence, size_t inputSize) {
+    if (inputSize > std::numeric_limits<uint32_t>::max()) {
+      throw std::invalid_argument("Invalid input size for permutation");
+    }
+    type_ = Table;
+    inputSize_ = inputSize;
+    outputSize_ = sequence.size();
+    if (inputSize <= size_t(std::numeric_limits<uint16_t>::max()) + 1) {
+      shortSequence_.assign(sequence.begin(), sequence.end());
+    } else {
+      sequence_.assign(sequence.begin(), sequence.end());
+    }
+  }
+  
+  Type type_ = Table;
+  std::vector<uint16_t> shortSequence_;
+  std::vector<uint32_t> sequence_;
+  std::vector<size_t> parameter_;
   size_t inputSize_ = 0;
+  size_t outputSize_ = 0;
 };
   
 }
 
+BOOST_CLASS_VERSION(fec::Permutation, 1);
+
+/**
+ *  Creates a permutation where each output element is picked at the same index.
+ *  \param  length  Length of the input and output sequence
+ */
+inline fec::Permutation fec::Permutation::identity(size_t length)
+{
+  Permutation perm;
+  perm.type_ = Identity;
+  perm.inputSize_ = length;
+  perm.outputSize_ = length;
+  return perm;
+}
+
+/**
+ *  Creates a quadratic permutation polynomial interleaver.
+ *  The index of the output element i is (f1*i + f2*i^2) mod length.
+ *  \param  length  Length of the input and output sequence
+ *  \param  f1  First order coefficient
+ *  \param  f2  Second order coefficient
+ */
+inline fec::Permutation fec::Permutation::qpp(size_t length, size_t f1, size_t f2)
+{
+  if (length == 0) {
+    throw std::invalid_argument("Invalid length for permutation");
+  }
+  Permutation perm;
+  perm.type_ = Qpp;
+  perm.inputSize_ = length;
+  perm.outputSize_ = length;
+  perm.parameter_ = {f1 % length, f2 % length};
+  return perm;
+}
+
+/**
+ *  Creates a permutation that picks elements according to a periodic mask.
+ *  The input element j is kept if mask[j % mask.size()] is true.
+ *  \param  mask  Mask applied periodicaly on the input sequence
+ *  \param  inputSize Length of the input sequence
+ */
+inline fec::Permutation fec::Permutation::periodic(const std::vector<bool>& mask, size_t inputSize)
+{
+  Permutation perm;
+  perm.type_ = Periodic;
+  perm.inputSize_ = inputSize;
+  perm.parameter_ = {mask.size()};
+  for (size_t i = 0; i < mask.size(); ++i) {
+    if (mask[i]) {
+      perm.parameter_.push_back(i);
+    }
+  }
+  if (mask.size() == 0 || perm.parameter_.size() == 1) {
+    throw std::invalid_argument("Invalid mask for permutation");
+  }
+  perm.outputSize_ = inputSize / mask.size() * (perm.parameter_.size() - 1);
+  for (size_t i = 0; i < inputSize % mask.size(); ++i) {
+    perm.outputSize_ += mask[i];
+  }
+  return perm;
+}
+
+/**
+ *  Creates a block interleaver.
+ *  Elements are written row by row in a matrix and read column by column.
+ *  \param  rowCount  Number of rows of the matrix
+ *  \param  colCount  Number of columns of the matrix
+ */
+inline fec::Permutation fec::Permutation::block(size_t rowCount, size_t colCount)
+{
+  Permutation perm;
+  perm.type_ = Block;
+  perm.inputSize_ = rowCount * colCount;
+  perm.outputSize_ = rowCount * colCount;
+  perm.parameter_ = {rowCount, colCount};
+  return perm;
+}
+
+/**
+ *  Access the source index of an output element.
+ *  Prefer permuteBlock or forEach to access the whole sequence,
+ *  since generated indices are computed incrementally there.
+ *  \param  i Index of the output element
+ */
+inline size_t fec::Permutation::operator[] (size_t i) const
+{
+  switch (type_) {
+    default:
+    case Table:
+      return shortSequence_.size() ? shortSequence_[i] : sequence_[i];
+      
+    case Identity:
+      return i;
+      
+    case Qpp: {
+      uint64_t x = i % inputSize_;
+      return (parameter_[0] * x + parameter_[1] * (x * x % inputSize_)) % inputSize_;
+    }
+      
+    case Periodic: {
+      size_t count = parameter_.size() - 1;
+      return (i / count) * parameter_[0] + parameter_[1 + i % count];
+    }
+      
+    case Block:
+      return (i % parameter_[0]) * parameter_[1] + i / parameter_[0];
+  }
+}
+
+template <class F>
+void fec::Permutation::forEach(F f) const
+{
+  switch (type_) {
+    default:
+    case Table:
+      if (shortSequence_.size()) {
+        for (size_t i = 0; i < shortSequence_.size(); ++i) {
+          f(i, shortSequence_[i]);
+        }
+      } else {
+        for (size_t i = 0; i < sequence_.size(); ++i) {
+          f(i, sequence_[i]);
+        }
+      }
+      break;
+      
+    case Identity:
+      for (size_t i = 0; i < outputSize_; ++i) {
+        f(i, i);
+      }
+      break;
+      
+    case Qpp: {
+      // pi(i+1) = pi(i) + g(i) where g(i+1) = g(i) + 2*f2 (mod length)
+      size_t length = inputSize_;
+      size_t idx = 0;
+      size_t step = (parameter_[0] + parameter_[1]) % length;
+      size_t stepIncrement = (2 * parameter_[1]) % length;
+      for (size_t i = 0; i < length; ++i) {
+        f(i, idx);
+        idx += step;
+        if (idx >= length) idx -= length;
+        step += stepIncrement;
+        if (step >= length) step -= length;
+      }
+      break;
+    }
+      
+    case Periodic: {
+      size_t i = 0;
+      for (size_t base = 0; i < outputSize_; base += parameter_[0]) {
+        for (size_t j = 1; j < parameter_.size() && i < outputSize_; ++j, ++i) {
+          f(i, base + parameter_[j]);
+        }
+      }
+      break;
+    }
+      
+    case Block: {
+      size_t i = 0;
+      for (size_t col = 0; col < parameter_[1]; ++col) {
+        for (size_t idx = col; idx < inputSize_; idx += parameter_[1], ++i) {
+          f(i, idx);
+        }
+      }
+      break;
+    }
+  }
+}
+
 /*fec::Permutation range(size_t begin, size_t end)
 {
   std::vector<size_t> perm;
@@ -175,17 +404,13 @@ void fec::Permutation::dePermuteBlocks(typename std::vector<T1>::const_iterator
 template <typename T1, typename T2>
 void fec::Permutation::permuteBlock(typename std::vector<T1>::const_iterator input, typename std::vector<T2>::iterator output) const
 {
-  for (size_t i = 0; i < sequence_.size(); i++) {
-    output[i] = input[sequence_[i]];
-  }
+  forEach([&](size_t i, size_t j) {output[i] = input[j];});
 }
 
 template <typename T1, typename T2>
 void fec::Permutation::dePermuteBlock(typename std::vector<T1>::const_iterator input, typename std::vector<T2>::iterator output) const
 {
-  for (size_t i = 0; i < sequence_.size(); i++) {
-    output[sequence_[i]] = input[i];
-  }
+  forEach([&](size_t i, size_t j) {output[j] = input[i];});
 }
 
 #endif
\ No newline at end of file
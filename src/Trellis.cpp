@@ -61,6 +61,7 @@ Trellis::Trellis(const std::vector<BitField<size_t>>& nextState, const std::vect
       assert(output_[i*inputCount()+j] < outputCount());
     }
   }
+  computePredecessors();
 }
 
 /**
@@ -140,6 +141,84 @@ Trellis::Trellis(const std::vector<size_t>& constraintLengths, const std::vector
       }
     }
   }
+  computePredecessors();
+}
+
+/**
+ *  Creates the two-step (radix-4 for binary input) version of the trellis.
+ *  Each branch of the collapsed trellis represents two consecutive branches.
+ *  Input and output bits of the first step are in the least significant bits.
+ *  \return Collapsed trellis
+ */
+Trellis Trellis::collapse() const
+{
+  Trellis trellis;
+  trellis.stateSize_ = stateSize();
+  trellis.inputSize_ = 2 * inputSize();
+  trellis.outputSize_ = 2 * outputSize();
+  
+  trellis.stateCount_ = stateCount();
+  trellis.inputCount_ = inputCount() * inputCount();
+  trellis.outputCount_ = outputCount() * outputCount();
+  
+  trellis.nextState_.resize(trellis.stateCount()*trellis.inputCount());
+  trellis.output_.resize(trellis.stateCount()*trellis.inputCount());
+  
+  for (size_t state = 0; state < stateCount(); ++state) {
+    for (size_t input = 0; input < trellis.inputCount(); ++input) {
+      size_t first = input % inputCount();
+      size_t second = input / inputCount();
+      BitField<size_t> midState = getNextState(state, first);
+      trellis.nextState_[state*trellis.inputCount()+input] = getNextState(midState, second);
+      trellis.output_[state*trellis.inputCount()+input] = getOutput(state, first) | (getOutput(midState, second) << outputSize());
+    }
+  }
+  trellis.computePredecessors();
+  return trellis;
+}
+
+/**
+ *  Computes the predecessor tables of the trellis.
+ *  Predecessors of each state are stored in increasing order of branch (state, input)
+ *  such that recursions gathering from them visit branches in the same order
+ *  as recursions scattering along the successor tables.
+ *  The tables are left empty when a state is not reached by exactly inputCount branches,
+ *  or when the trellis does not fit in the narrow types of the tables.
+ */
+void Trellis::computePredecessors()
+{
+  previousState_.clear();
+  previousInput_.clear();
+  previousOutput_.clear();
+  butterfly_ = false;
+  if (stateCount() > (size_t(1) << 16) || inputCount() > (size_t(1) << 8) || outputCount() > (size_t(1) << 16)) {
+    return;
+  }
+  std::vector<size_t> count(stateCount(), 0);
+  for (size_t i = 0; i < tableSize(); ++i) {
+    if (++count[nextState_[i]] > inputCount()) {
+      return;
+    }
+  }
+  previousState_.resize(tableSize());
+  previousInput_.resize(tableSize());
+  previousOutput_.resize(tableSize());
+  std::fill(count.begin(), count.end(), 0);
+  for (size_t state = 0; state < stateCount(); ++state) {
+    for (size_t input = 0; input < inputCount(); ++input) {
+      size_t nextState = getNextState(state, input);
+      size_t idx = nextState * inputCount() + count[nextState]++;
+      previousState_[idx] = uint16_t(state);
+      previousInput_[idx] = uint8_t(input);
+      previousOutput_[idx] = uint16_t(getOutput(state, input));
+    }
+  }
+  
+  butterfly_ = (inputCount() == 2 && stateCount() >= 2);
+  for (size_t state = 0; state < stateCount() && butterfly_; ++state) {
+    size_t first = 2 * (state % (stateCount()/2));
+    butterfly_ = (previousState_[state*2] == first && previousState_[state*2+1] == first+1);
+  }
 }
 
 std::ostream& operator<<(std::ostream& os, const Trellis& trellis)
@@ -24,6 +24,7 @@
 
 #include <assert.h>
 #include <iostream>
+#include <stdint.h>
 
 #include <vector>
 #include <boost/serialization/nvp.hpp>
@@ -85,6 +86,8 @@ public:
   
   Trellis& operator=(const Trellis& b) = default;
   
+  Trellis collapse() const;
+  
   /**
    *  Access the state size (register count) of the trellis.
    *  \return State size
@@ -121,6 +124,21 @@ public:
    *  \return Table size
    */
   inline size_t tableSize() const {return nextState_.size();}
+  /**
+   *  Access if the trellis is made of butterflies.
+   *  This is the case of binary input shift register codes,
+   *  where states 2j and 2j+1 both lead to states j and j + stateCount/2.
+   *  \return True if the trellis is made of butterflies
+   */
+  inline bool isButterfly() const {return butterfly_;}
+  /**
+   *  Access if the predecessor tables are available.
+   *  They are built when every state is reached by exactly inputCount branches,
+   *  which is the case for shift register codes, and when the trellis is small enough for their narrow types.
+   *  Decoders fall back to scattering along the successor tables otherwise.
+   *  \return True if the predecessor tables are available
+   */
+  inline bool hasPredecessors() const {return !previousState_.empty();}
   
   /**
    *  Access the next state given a current state and an input bit sequence.
@@ -171,7 +189,33 @@ public:
    */
   inline std::vector<BitField<size_t> >::const_iterator endOutput() const {return output_.end();}
   
+  /**
+   *  Access a random access input iterator pointing to the first element in the lookup previous state table.
+   *  This allow to access the states leading to a given state.
+   *  The table is empty if the trellis has no predecessor tables.
+   *  The table is in row major form, where each row is associated with one state
+   *  and contains its inputCount predecessors in increasing order of branch.
+   *  \return Random access input iterator to the previous state table
+   */
+  inline std::vector<uint16_t>::const_iterator beginPreviousState() const {return previousState_.begin();}
+  /**
+   *  Access a random access input iterator pointing to the first element in the lookup previous input table.
+   *  This allow to access the input sequence of the branches leading to a given state.
+   *  The table has the same layout as the previous state table.
+   *  \return Random access input iterator to the previous input table
+   */
+  inline std::vector<uint8_t>::const_iterator beginPreviousInput() const {return previousInput_.begin();}
+  /**
+   *  Access a random access input iterator pointing to the first element in the lookup previous output table.
+   *  This allow to access the output symbol sequence of the branches leading to a given state.
+   *  The table has the same layout as the previous state table.
+   *  \return Random access input iterator to the previous output table
+   */
+  inline std::vector<uint16_t>::const_iterator beginPreviousOutput() const {return previousOutput_.begin();}
+  
 private:
+  void computePredecessors();
+  
   template <typename Archive>
   void serialize(Archive & ar, const unsigned int version) {
     ar & ::BOOST_SERIALIZATION_NVP(stateSize_);
@@ -182,6 +226,9 @@ private:
     ar & ::BOOST_SERIALIZATION_NVP(outputCount_);
     ar & ::BOOST_SERIALIZATION_NVP(nextState_);
     ar & ::BOOST_SERIALIZATION_NVP(output_);
+    if (Archive::is_loading::value) {
+      computePredecessors();
+    }
   }
   
   size_t stateSize_;
@@ -194,6 +241,11 @@ private:
   
   std::vector<BitField<size_t> > nextState_;
   std::vector<BitField<size_t> > output_;
+  
+  std::vector<uint16_t> previousState_;
+  std::vector<uint8_t> previousInput_;
+  std::vector<uint16_t> previousOutput_;
+  bool butterfly_ = false;
 };
 
 }
@@ -47,14 +47,25 @@ const char * Turbo::get_key() const
   return boost::serialization::type_info_implementation<Turbo>::type::get_const_instance().get_key();
 }
 
+void Turbo::encodeBlocks(std::vector<BitField<size_t>>::const_iterator msg, std::vector<BitField<size_t>>::iterator parity, size_t n) const
+{
+  structure().encode(msg, parity, n);
+}
+
 void Turbo::decodeBlocks(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, size_t n) const
 {
-  auto worker = detail::TurboDecoder::create(structure());
+  auto worker = workerDecoder<detail::TurboDecoder>([&] {return detail::TurboDecoder::create(structure());});
   worker->decodeBlocks(parity, msg, n);
 }
 
+void Turbo::timedDecodeBlocks(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, std::vector<BitField<size_t>>::iterator converged, size_t n, detail::Codec::Deadline& deadline) const
+{
+  auto worker = workerDecoder<detail::TurboDecoder>([&] {return detail::TurboDecoder::create(structure());});
+  worker->decodeBlocks(parity, msg, converged, n, deadline);
+}
+
 void Turbo::soDecodeBlocks(detail::Codec::InputIterator input, detail::Codec::OutputIterator output, size_t n) const
 {
-  auto worker = detail::TurboDecoder::create(structure());
+  auto worker = workerDecoder<detail::TurboDecoder>([&] {return detail::TurboDecoder::create(structure());});
   worker->soDecodeBlocks(input, output, n);
 }
@@ -76,11 +76,28 @@ namespace fec {
        *  \return A Permutation of the specified length as defined in the standard.
        */
       static Permutation interleaver(size_t length);
+      /**
+       *  Access the circular buffer rate matching defined in the standard.
+       *  The parity of the codec is split in the three bit streams of the standard,
+       *  each stream goes through the sub-block interleaver and bits are
+       *  selected from the circular buffer, starting at the position given by
+       *  the redundancy version.
+       *  Null bits are skipped and bits are repeated if outputSize exceeds the buffer.
+       *  \param  codec Turbo codec with 2 constituents of rate 1
+       *  \param  outputSize  Number of transmitted bits (E in the standard)
+       *  \param  redundancyVersion Redundancy version between 0 and 3
+       *  \param  softBufferSize  Size of the circular buffer (Ncb in the standard).
+       *    The full buffer is used if zero.
+       *  \return A Permutation from the codec parity to the transmitted bits.
+       */
+      static Permutation rateMatching(const Turbo& codec, size_t outputSize, size_t redundancyVersion = 0, size_t softBufferSize = 0);
       //static Structure structure();
       //static Turbo codec();
       //static Permutation permutation();
       
     private:
+      static const size_t columnCount_ = 32;
+      static const std::array<size_t, columnCount_> columnPermutation_;
       static const std::array<size_t, 188> length_;
       static const std::array<double, 188> rate_;
       static const std::vector<std::vector<size_t>> parameter_;
@@ -107,8 +124,10 @@ namespace fec {
     inline const detail::Turbo::Structure& structure() const {return dynamic_cast<const detail::Turbo::Structure&>(Codec::structure());}
     inline detail::Turbo::Structure& structure() {return dynamic_cast<detail::Turbo::Structure&>(Codec::structure());}
     
+    virtual void encodeBlocks(std::vector<BitField<size_t>>::const_iterator msg, std::vector<BitField<size_t>>::iterator parity, size_t n) const;
     virtual void decodeBlocks(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, size_t n) const;
     virtual void soDecodeBlocks(detail::Codec::InputIterator input, detail::Codec::OutputIterator output, size_t n) const;
+    virtual void timedDecodeBlocks(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, std::vector<BitField<size_t>>::iterator converged, size_t n, detail::Codec::Deadline& deadline) const;
     
   private:
     template <typename Archive>
@@ -0,0 +1,169 @@
+/*******************************************************************************
+ This file is part of FeCl.
+ 
+ Copyright (c) 2015, Etienne Pierre-Doray, INRS
+ Copyright (c) 2015, Leszek Szczecinski, INRS
+ All rights reserved.
+ 
+ FeCl is free software: you can redistribute it and/or modify
+ it under the terms of the Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ FeCl is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the Lesser General Public License
+ along with FeCl.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <cstdint>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "Arena.h"
+
+using namespace fec::detail;
+
+const size_t Arena::alignment;
+
+namespace {
+  
+  thread_local Arena* currentArena = nullptr;
+
+}
+
+/**
+ *  Arena constructor.
+ *  When the region cannot be mapped, it is allocated from the heap,
+ *  and options which cannot be honored are ignored.
+ *  \param  size Size of the region in bytes
+ *  \param  hugePages Wether the region is backed by huge pages.
+ *    Explicit huge pages are used if the system reserved some,
+ *    otherwise transparent huge pages are requested.
+ *  \param  lock Wether the region is locked in memory, such that it is never paged out
+ */
+Arena::Arena(size_t size, bool hugePages, bool lock)
+{
+  if (size == 0) {
+    return;
+  }
+#if defined(__unix__) || defined(__APPLE__)
+  const size_t hugePageSize = size_t(1) << 21;
+  size_t pageSize = ::sysconf(_SC_PAGESIZE);
+  capacity_ = (size + pageSize - 1) / pageSize * pageSize;
+  void* data = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+  if (hugePages) {
+    size_t hugeCapacity = (size + hugePageSize - 1) / hugePageSize * hugePageSize;
+    data = ::mmap(nullptr, hugeCapacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (data != MAP_FAILED) {
+      capacity_ = hugeCapacity;
+      hugePages_ = true;
+    }
+  }
+#endif
+  if (data == MAP_FAILED) {
+    data = ::mmap(nullptr, capacity_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#if defined(MADV_HUGEPAGE)
+    if (data != MAP_FAILED && hugePages) {
+      hugePages_ = ::madvise(data, capacity_, MADV_HUGEPAGE) == 0;
+    }
+#endif
+  }
+  if (data != MAP_FAILED) {
+    data_ = static_cast<char*>(data);
+    mapped_ = true;
+    if (lock) {
+      locked_ = ::mlock(data_, capacity_) == 0;
+    }
+    return;
+  }
+#endif
+  capacity_ = (size + alignment - 1) / alignment * alignment;
+  data_ = static_cast<char*>(allocateAligned(capacity_));
+}
+
+Arena::~Arena()
+{
+#if defined(__unix__) || defined(__APPLE__)
+  if (mapped_) {
+    if (locked_) {
+      ::munlock(data_, capacity_);
+    }
+    ::munmap(data_, capacity_);
+    return;
+  }
+#endif
+  deallocateAligned(data_);
+}
+
+/**
+ *  Allocates a buffer aligned on a cache line.
+ *  \param  size Size of the buffer in bytes
+ *  \return Pointer to the buffer, or nullptr if the arena is full
+ */
+void* Arena::allocate(size_t size)
+{
+  size_t first = (used_ + alignment - 1) / alignment * alignment;
+  if (first > capacity_ || size > capacity_ - first) {
+    return nullptr;
+  }
+  used_ = first + size;
+  return data_ + first;
+}
+
+/**
+ *  Access the arena of the calling thread.
+ *  \return Current arena, or nullptr if buffers come from the heap
+ */
+Arena* Arena::current()
+{
+  return currentArena;
+}
+
+/**
+ *  Allocates a buffer aligned on a cache line from the heap.
+ *  The address of the block is kept in front of the buffer.
+ *  \param  size Size of the buffer in bytes
+ *  \return Pointer to the buffer
+ */
+void* Arena::allocateAligned(size_t size)
+{
+  char* block = static_cast<char*>(::operator new(size + alignment));
+  char* ptr = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(block) + alignment) & ~uintptr_t(alignment - 1));
+  reinterpret_cast<char**>(ptr)[-1] = block;
+  return ptr;
+}
+
+/**
+ *  Frees a buffer allocated by allocateAligned.
+ */
+void Arena::deallocateAligned(void* ptr)
+{
+  if (ptr != nullptr) {
+    ::operator delete(static_cast<char**>(ptr)[-1]);
+  }
+}
+
+Arena::Scope::Scope(Arena* arena) : arena_(arena), previous_(currentArena)
+{
+  if (arena_ != nullptr) {
+    mark_ = arena_->used();
+  }
+  currentArena = arena_;
+}
+
+Arena::Scope::~Scope()
+{
+  if (arena_ != nullptr) {
+    arena_->reset(mark_);
+  }
+  currentArena = previous_;
+}
@@ -0,0 +1,146 @@
+/*******************************************************************************
+ This file is part of FeCl.
+ 
+ Copyright (c) 2015, Etienne Pierre-Doray, INRS
+ Copyright (c) 2015, Leszek Szczecinski, INRS
+ All rights reserved.
+ 
+ FeCl is free software: you can redistribute it and/or modify
+ it under the terms of the Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ FeCl is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the Lesser General Public License
+ along with FeCl.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#ifndef FEC_DETAIL_ARENA_H
+#define FEC_DETAIL_ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+namespace fec {
+  
+  namespace detail {
+    
+    /**
+     *  This class is a region of memory from which buffers are allocated by bumping an offset.
+     *  Every buffer is aligned on a cache line, such that vector loads do not cross lines.
+     *  The region is mapped from the operating system, optionally with huge pages to reduce TLB misses
+     *  and locked in memory for real-time use.
+     *  Buffers are not freed one by one, the arena is reset to a previous offset instead.
+     *  An arena is used by a single thread at a time.
+     */
+    class Arena {
+    public:
+      static const size_t alignment = 64;
+      
+      /**
+       *  Sets the arena from which the buffers of the calling thread are allocated
+       *  for the lifetime of the object.
+       *  Buffers allocated during the scope are released at its end.
+       */
+      class Scope {
+      public:
+        Scope(Arena* arena);
+        ~Scope();
+        
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+      
+      private:
+        Arena* arena_;
+        Arena* previous_;
+        size_t mark_ = 0;
+      };
+      
+      Arena(size_t size, bool hugePages = false, bool lock = false);
+      ~Arena();
+      
+      Arena(const Arena&) = delete;
+      Arena& operator=(const Arena&) = delete;
+      
+      size_t capacity() const {return capacity_;} /**< Access the size of the region. */
+      size_t used() const {return used_;} /**< Access the size allocated from the region. */
+      bool isHugePages() const {return hugePages_;} /**< Access wether the region is backed by huge pages. */
+      bool isLocked() const {return locked_;} /**< Access wether the region is locked in memory. */
+      
+      void* allocate(size_t size);
+      bool owns(const void* ptr) const {return ptr >= data_ && ptr < data_ + capacity_;} /**< Access wether a buffer was allocated from the arena. */
+      void reset(size_t mark = 0) {used_ = mark;} /**< Releases the buffers allocated after a previous offset. */
+      
+      static Arena* current();
+      static void* allocateAligned(size_t size);
+      static void deallocateAligned(void* ptr);
+    
+    private:
+      char* data_ = nullptr;
+      size_t capacity_ = 0;
+      size_t used_ = 0;
+      bool mapped_ = false;
+      bool hugePages_ = false;
+      bool locked_ = false;
+    };
+    
+    /**
+     *  This allocator gives buffers aligned on a cache line.
+     *  Buffers come from the arena of the thread when the allocator is created, if there is one and it has room,
+     *  and from the heap otherwise.
+     */
+    template <typename T>
+    class AlignedAllocator {
+      template <typename U> friend class AlignedAllocator;
+    public:
+      using value_type = T;
+      
+      AlignedAllocator() : arena_(Arena::current()) {}
+      template <typename U>
+      AlignedAllocator(const AlignedAllocator<U>& other) : arena_(other.arena_) {}
+      
+      inline T* allocate(size_t n);
+      inline void deallocate(T* ptr, size_t n);
+      
+      template <typename U>
+      bool operator==(const AlignedAllocator<U>& other) const {return arena_ == other.arena_;}
+      template <typename U>
+      bool operator!=(const AlignedAllocator<U>& other) const {return arena_ != other.arena_;}
+    
+    private:
+      Arena* arena_;
+    };
+    
+    template <typename T>
+    using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+  
+  }
+
+}
+
+template <typename T>
+T* fec::detail::AlignedAllocator<T>::allocate(size_t n)
+{
+  void* ptr = nullptr;
+  if (arena_ != nullptr) {
+    ptr = arena_->allocate(n * sizeof(T));
+  }
+  if (ptr == nullptr) {
+    ptr = Arena::allocateAligned(n * sizeof(T));
+  }
+  return static_cast<T*>(ptr);
+}
+
+template <typename T>
+void fec::detail::AlignedAllocator<T>::deallocate(T* ptr, size_t)
+{
+  if (arena_ == nullptr || !arena_->owns(ptr)) {
+    Arena::deallocateAligned(ptr);
+  }
+}
+
+#endif
@@ -45,7 +45,21 @@ std::unique_ptr<BpDecoder> BpDecoder::create(const Ldpc::Structure& structure)
 void BpDecoder::decodeBlocks(std::vector<double>::const_iterator parity, std::vector<fec::BitField<size_t>>::iterator msg, size_t n)
 {
   for (size_t i = 0; i < n; ++i) {
-    decodeBlock(parity, msg);
+    decodeBlock(parity, msg, Codec::Deadline::Clock::time_point::max());
+    parity += structure().paritySize();
+    msg += structure().msgSize();
+  }
+}
+
+/**
+ *  Decodes several blocks, each before the deadline given when it starts.
+ *  \param  converged[out] Output iterator pointing to the first element in the convergence flag sequence.
+ *  \param  deadline Budget shared by the blocks of the batch
+ */
+void BpDecoder::decodeBlocks(std::vector<double>::const_iterator parity, std::vector<fec::BitField<size_t>>::iterator msg, std::vector<fec::BitField<size_t>>::iterator converged, size_t n, Codec::Deadline& deadline)
+{
+  for (size_t i = 0; i < n; ++i) {
+    converged[i] = decodeBlock(parity, msg, deadline.next());
     parity += structure().paritySize();
     msg += structure().msgSize();
   }
@@ -24,6 +24,7 @@
 
 #include <vector>
 #include <memory>
+#include <stdint.h>
 
 #include "../../Ldpc.h"
 
@@ -45,12 +46,13 @@ namespace fec {
       virtual ~BpDecoder() = default;
       
       void decodeBlocks(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, size_t n);
+      void decodeBlocks(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, std::vector<BitField<size_t>>::iterator converged, size_t n, Codec::Deadline& deadline);
       void soDecodeBlocks(Codec::InputIterator input, Codec::OutputIterator output, size_t n);
       
     protected:
       BpDecoder(const Ldpc::Structure& codeStructure);
       
-      virtual void decodeBlock(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg) = 0;
+      virtual bool decodeBlock(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, Codec::Deadline::Clock::time_point deadline) = 0;
       virtual void soDecodeBlock(Codec::InputIterator input, Codec::OutputIterator output) = 0;
       
       inline const Ldpc::Structure& structure() const {return structure_;}
@@ -29,29 +29,108 @@ BpDecoder(structure)
 {
   hardParity_.resize(this->structure().checks().cols());
   parity_.resize(this->structure().checks().cols());
-  checkMetrics_.resize(this->structure().checks().size());
-  checkMetricsBuffer_.resize(this->structure().checks().size());
   bitMetrics_.resize(this->structure().checks().cols());
+  if (BoxSumAlg<LlrMetrics>::isCompressible::value) {
+    checkMin_.resize(2*this->structure().checks().rows());
+    checkMinIdx_.resize(this->structure().checks().rows());
+    checkSigns_.resize((this->structure().checks().size()+63)/64);
+    bitMetricsBuffer_.resize(this->structure().checks().cols());
+  }
+  else {
+    checkMetrics_.resize(this->structure().checks().size());
+    checkMetricsBuffer_.resize(this->structure().checks().size());
+  }
+  
+  if (this->structure().checks().size() > std::numeric_limits<uint32_t>::max()) {
+    throw std::invalid_argument("Too many edges in check matrix");
+  }
+  
+  checkOrder_ = this->structure().checkOrder();
+  bitOrder_ = this->structure().bitOrder();
+  std::vector<uint32_t> bitIdx(bitOrder_.size());
+  for (size_t i = 0; i < bitOrder_.size(); ++i) {
+    bitIdx[bitOrder_[i]] = uint32_t(i);
+  }
+  std::vector<size_t> checkOffsets(this->structure().checks().rows()+1, 0);
+  for (size_t i = 0; i < this->structure().checks().rows(); ++i) {
+    checkOffsets[i+1] = checkOffsets[i] + this->structure().checks()[i].size();
+  }
+  
+  edgeOrder_.reserve(this->structure().checks().size());
+  edgeBits_.reserve(this->structure().checks().size());
+  checkEdgeOffsets_.reserve(checkOrder_.size()+1);
+  for (auto check : checkOrder_) {
+    size_t size = this->structure().checks()[check].size();
+    if (size >= checkGroups_.size()) {
+      checkGroups_.resize(size+1);
+    }
+    checkGroups_[size].push_back(checkEdgeOffsets_.size());
+    checkEdgeOffsets_.push_back(edgeOrder_.size());
+    for (size_t j = checkOffsets[check]; j < checkOffsets[check+1]; ++j) {
+      edgeOrder_.push_back(uint32_t(j));
+      edgeBits_.push_back(bitIdx[this->structure().checks().at(j)]);
+    }
+  }
+  checkEdgeOffsets_.push_back(edgeOrder_.size());
+  checkBatch_.resize(2 * checkGroups_.size() * laneCount_);
+  
+  if (this->structure().compactState()) {
+    std::vector<size_t> stateOffsets(this->structure().checks().rows()+1, 0);
+    for (size_t i = 0; i < this->structure().checks().rows(); ++i) {
+      stateOffsets[i+1] = stateOffsets[i] + Ldpc::Structure::compactStateSize(this->structure().checks()[i].size());
+    }
+    stateOffsets_.resize(checkOrder_.size());
+    for (size_t i = 0; i < checkOrder_.size(); ++i) {
+      stateOffsets_[i] = stateOffsets[checkOrder_[i]];
+    }
+  }
+  
+  bitEdgeOffsets_.assign(this->structure().checks().cols()+1, 0);
+  for (size_t i = 0; i < edgeBits_.size(); ++i) {
+    ++bitEdgeOffsets_[edgeBits_[i]+1];
+  }
+  for (size_t i = 0; i < this->structure().checks().cols(); ++i) {
+    bitEdgeOffsets_[i+1] += bitEdgeOffsets_[i];
+  }
+  bitEdges_.resize(edgeBits_.size());
+  std::vector<uint32_t> bitEdgeIdx(bitEdgeOffsets_.begin(), bitEdgeOffsets_.end()-1);
+  for (size_t i = 0; i < edgeBits_.size(); ++i) {
+    bitEdges_[bitEdgeIdx[edgeBits_[i]]++] = uint32_t(i);
+  }
 }
 
+/**
+ *  Decodes one bloc of information bits.
+ *  Iterations stop when the hard decisions satisfy every check, or once the deadline is passed.
+ *  \return  True if the hard decisions satisfied every check
+ */
 template <class LlrMetrics, template <class> class BoxSumAlg>
-void BpDecoderImpl<LlrMetrics, BoxSumAlg>::decodeBlock(std::vector<double>::const_iterator parity, std::vector<fec::BitField<size_t>>::iterator msg)
+bool BpDecoderImpl<LlrMetrics, BoxSumAlg>::decodeBlock(std::vector<double>::const_iterator parity, std::vector<fec::BitField<size_t>>::iterator msg, Codec::Deadline::Clock::time_point deadline)
 {
-  std::copy(parity, parity+structure().checks().cols(), parity_.begin());
+  if (BoxSumAlg<LlrMetrics>::isCompressible::value) {
+    return minSumDecodeBlock(parity, msg, deadline);
+  }
+  
+  for (size_t i = 0; i < structure().checks().cols(); ++i) {
+    parity_[i] = parity[bitOrder_[i]];
+  }
 
   if (structure().iterations() > 0) {
-    for (size_t i = 0; i < structure().checks().size(); ++i) {
-      checkMetrics_[i] = parity_[structure().checks().at(i)];
+    for (size_t i = 0; i < edgeBits_.size(); ++i) {
+      checkMetrics_[i] = parity_[edgeBits_[i]];
     }
   }
   
   bool success = false;
-  for (int64_t i = 0; i < structure().iterations() - 1; ++i) {
+  for (int64_t i = 0; i < int64_t(structure().iterations()) - 1; ++i) {
+    if (Codec::Deadline::isExpired(deadline)) {
+      break;
+    }
     checkUpdate(i);
     bitUpdate();
     
     for (size_t j = 0; j < structure().checks().cols(); ++j) {
-      hardParity_[j] = (bitMetrics_[j] >= 0.0);
+      hardParity_[bitOrder_[j]] = (bitMetrics_[j] >= 0.0);
     }
     if (structure().check(hardParity_.begin())) {
       success = true;
@@ -60,26 +139,40 @@ void BpDecoderImpl<LlrMetrics, BoxSumAlg>::decodeBlock(std::vector<double>::cons
   }
   checkUpdate(structure().iterations()-1);
   
-  std::copy(parity_.begin(), parity_.end(), bitMetrics_.begin());
-  for (size_t i = 0; i < structure().checks().size(); ++i) {
-    bitMetrics_[structure().checks().at(i)] += checkMetrics_[i];
-  }
-  for (size_t i = 0; i < structure().msgSize(); ++i) {
-    msg[i] = bitMetrics_[i] >= 0;
+  for (size_t i = 0; i < structure().checks().cols(); ++i) {
+    typename LlrMetrics::Type sum = parity_[i];
+    for (size_t k = bitEdgeOffsets_[i]; k < bitEdgeOffsets_[i+1]; ++k) {
+      sum += checkMetrics_[bitEdges_[k]];
+    }
+    if (bitOrder_[i] < structure().msgSize()) {
+      msg[bitOrder_[i]] = sum >= 0;
+    }
   }
+  return success;
 }
 
 template <class LlrMetrics, template <class> class BoxSumAlg>
 void BpDecoderImpl<LlrMetrics, BoxSumAlg>::soDecodeBlock(Codec::InputIterator input, Codec::OutputIterator output)
 {
-  std::copy(input.parity(), input.parity()+structure().checks().cols(), parity_.begin());
+  if (BoxSumAlg<LlrMetrics>::isCompressible::value) {
+    minSumSoDecodeBlock(input, output);
+    return;
+  }
+  
+  for (size_t i = 0; i < structure().checks().cols(); ++i) {
+    parity_[i] = input.parity()[bitOrder_[i]];
+  }
   if (input.hasSyst()) {
-    for (size_t i = 0; i < structure().systSize(); ++i) {
-      parity_[i] += input.syst()[i];
+    for (size_t i = 0; i < structure().checks().cols(); ++i) {
+      if (bitOrder_[i] < structure().systSize()) {
+        parity_[i] += input.syst()[bitOrder_[i]];
+      }
     }
   }
   if (input.hasState()) {
-    std::copy(input.state(), input.state()+structure().stateSize(), checkMetrics_.begin());
+    for (size_t i = 0; i < edgeOrder_.size(); ++i) {
+      checkMetrics_[i] = input.state()[edgeOrder_[i]];
+    }
   }
   
   if (structure().iterations() > 0) {
@@ -87,94 +180,392 @@ void BpDecoderImpl<LlrMetrics, BoxSumAlg>::soDecodeBlock(Codec::InputIterator in
       bitUpdate();
     }
     else {
-      for (size_t i = 0; i < structure().checks().size(); ++i) {
-        checkMetrics_[i] = parity_[structure().checks().at(i)];
+      for (size_t i = 0; i < edgeBits_.size(); ++i) {
+        checkMetrics_[i] = parity_[edgeBits_[i]];
       }
     }
   }
 
-  bool success = false;
-  for (int64_t i = 0; i < structure().iterations() - 1; ++i) {
+  for (int64_t i = 0; i < int64_t(structure().iterations()) - 1; ++i) {
     checkUpdate(i);
     bitUpdate();
     
     for (size_t j = 0; j < structure().checks().cols(); ++j) {
-      hardParity_[j] = (bitMetrics_[j] >= 0.0);
+      hardParity_[bitOrder_[j]] = (bitMetrics_[j] >= 0.0);
     }
     if (structure().check(hardParity_.begin())) {
-      success = true;
       break;
     }
   }
   checkUpdate(structure().iterations()-1);
   
-  std::fill(bitMetrics_.begin(), bitMetrics_.end(), 0);
-  for (size_t i = 0; i < structure().checks().size(); ++i) {
-    bitMetrics_[structure().checks().at(i)] += checkMetrics_[i];
+  for (size_t i = 0; i < structure().checks().cols(); ++i) {
+    typename LlrMetrics::Type sum = 0;
+    for (size_t k = bitEdgeOffsets_[i]; k < bitEdgeOffsets_[i+1]; ++k) {
+      sum += checkMetrics_[bitEdges_[k]];
+    }
+    bitMetrics_[i] = sum;
   }
   
-  if (output.hasSyst()) {
-    std::copy(bitMetrics_.begin(), bitMetrics_.begin()+structure().systSize(), output.syst());
-  }
-  if (output.hasParity()) {
-    std::copy(bitMetrics_.begin(), bitMetrics_.begin()+structure().checks().cols(), output.parity());
+  for (size_t i = 0; i < structure().checks().cols(); ++i) {
+    size_t j = bitOrder_[i];
+    if (output.hasSyst() && j < structure().systSize()) {
+      output.syst()[j] = bitMetrics_[i];
+    }
+    if (output.hasParity()) {
+      output.parity()[j] = bitMetrics_[i];
+    }
+    if (output.hasMsg() && j < structure().msgSize()) {
+      output.msg()[j] = parity_[i] + bitMetrics_[i];
+    }
   }
   if (output.hasState()) {
-    std::copy(checkMetrics_.begin(), checkMetrics_.end(), output.state());
-  }
-  if (output.hasMsg()) {
-    for (size_t i = 0; i < structure().msgSize(); ++i) {
-      output.msg()[i] = parity_[i] + bitMetrics_[i];
+    for (size_t i = 0; i < edgeOrder_.size(); ++i) {
+      output.state()[edgeOrder_[i]] = checkMetrics_[i];
     }
   }
 }
 
+/**
+ *  Updates all check metrics.
+ *  Checks are processed by groups of equal degree,
+ *  with kernels specialized for the most common degrees.
+ *  \param  i Iteration index
+ */
 template <class LlrMetrics, template <class> class BoxSumAlg>
 void BpDecoderImpl<LlrMetrics, BoxSumAlg>::checkUpdate(size_t i)
 {
-  auto checkMetric = checkMetrics_.begin();
-  auto checkMetricTmp = checkMetricsBuffer_.begin();
-  for (auto check = structure().checks().begin(); check < structure().checks().end();  ++check) {
-    auto first = checkMetric;
-    size_t size = check->size();
-    double sf = structure().scalingFactor(i, size);
+  for (size_t degree = 2; degree < checkGroups_.size(); ++degree) {
+    const auto& checks = checkGroups_[degree];
+    if (checks.empty()) {
+      continue;
+    }
+    double sf = structure().scalingFactor(i, degree);
+    switch (degree) {
+      case 3: checkGroupUpdate<3>(checks, degree, sf); break;
+      case 4: checkGroupUpdate<4>(checks, degree, sf); break;
+      case 5: checkGroupUpdate<5>(checks, degree, sf); break;
+      case 6: checkGroupUpdate<6>(checks, degree, sf); break;
+      case 7: checkGroupUpdate<7>(checks, degree, sf); break;
+      case 8: checkGroupUpdate<8>(checks, degree, sf); break;
+      default: checkGroupUpdate<0>(checks, degree, sf); break;
+    }
+  }
+}
+
+/**
+ *  Updates the check metrics of a group of checks with the same degree.
+ *  Checks are loaded by batches of laneCount_ in an edge-major buffer
+ *  such that the box sum of every edge position is computed across the batch,
+ *  which the compiler can vectorize.
+ *  \tparam  Degree Check degree known at compile time, or 0 if only known at run time
+ *  \param  checks Internal index of each check in the group
+ *  \param  degree Check degree
+ *  \param  sf Scaling factor applied to the check metrics
+ */
+template <class LlrMetrics, template <class> class BoxSumAlg>
+template <size_t Degree>
+void BpDecoderImpl<LlrMetrics, BoxSumAlg>::checkGroupUpdate(const std::vector<size_t>& checks, size_t degree, double sf)
+{
+  const size_t size = (Degree != 0) ? Degree : degree;
+  auto prior = checkBatch_.begin();
+  auto forward = checkBatch_.begin() + size * laneCount_;
+  
+  size_t offset[laneCount_];
+  
+  for (size_t k = 0; k < checks.size(); k += laneCount_) {
+    const size_t lanes = std::min(laneCount_, checks.size() - k);
+    for (size_t l = 0; l < lanes; ++l) {
+      offset[l] = checkEdgeOffsets_[checks[k+l]];
+    }
     
-    double prod = boxSum_.prior(*first);
+    for (size_t j = 0; j < size; ++j) {
+      for (size_t l = 0; l < lanes; ++l) {
+        prior[j*laneCount_+l] = boxSum_.prior(checkMetrics_[offset[l]+j]);
+      }
+    }
+    for (size_t l = 0; l < lanes; ++l) {
+      forward[l] = prior[l];
+    }
     for (size_t j = 1; j < size-1; ++j) {
-      checkMetricTmp[j] = boxSum_.prior(first[j]);
-      first[j] = prod;
-      prod = boxSum_.sum(prod, checkMetricTmp[j]);
+      for (size_t l = 0; l < lanes; ++l) {
+        forward[j*laneCount_+l] = boxSum_.sum(forward[(j-1)*laneCount_+l], prior[j*laneCount_+l]);
+      }
+    }
+    
+    for (size_t l = 0; l < lanes; ++l) {
+      checkMetrics_[offset[l]+size-1] = sf * boxSum_.post(forward[(size-2)*laneCount_+l]);
     }
-    checkMetricTmp[size-1] = boxSum_.prior(first[size-1]);
-    first[size-1] = sf *  (boxSum_.post(prod));
-    prod = checkMetricTmp[size-1];
     for (size_t j = size-2; j > 0; --j) {
-      first[j] = sf *  (boxSum_.post( boxSum_.sum(first[j], prod) ));
-      prod = boxSum_.sum(prod, checkMetricTmp[j]);
+      for (size_t l = 0; l < lanes; ++l) {
+        checkMetrics_[offset[l]+j] = sf * boxSum_.post(boxSum_.sum(forward[(j-1)*laneCount_+l], prior[(j+1)*laneCount_+l]));
+        prior[j*laneCount_+l] = boxSum_.sum(prior[(j+1)*laneCount_+l], prior[j*laneCount_+l]);
+      }
+    }
+    for (size_t l = 0; l < lanes; ++l) {
+      checkMetrics_[offset[l]] = sf * boxSum_.post(prior[laneCount_+l]);
     }
-    *first = sf *  (boxSum_.post(prod));
-    
-    checkMetric += size;
   }
 }
 
+/**
+ *  Updates all bit metrics and the extrinsic check metrics.
+ *  Bits are processed one at a time through the column-major edge permutation,
+ *  such that the edges of each bit are a contiguous segment.
+ *  Check metrics are read and updated in place through the permutation
+ *  rather than copied in column-major order and back,
+ *  which saves two full passes over the edges.
+ */
 template <class LlrMetrics, template <class> class BoxSumAlg>
 void BpDecoderImpl<LlrMetrics, BoxSumAlg>::bitUpdate()
 {
+  for (size_t i = 0; i < structure().checks().cols(); ++i) {
+    const size_t first = bitEdgeOffsets_[i];
+    const size_t last = bitEdgeOffsets_[i+1];
+    
+    typename LlrMetrics::Type sum = 0;
+    for (size_t k = first; k < last; ++k) {
+      auto& ref = checkMetrics_[bitEdges_[k]];
+      checkMetricsBuffer_[k] = ref;
+      ref = sum;
+      sum += checkMetricsBuffer_[k];
+    }
+    
+    sum = parity_[i];
+    for (size_t k = last; k > first; --k) {
+      checkMetrics_[bitEdges_[k-1]] += sum;
+      sum += checkMetricsBuffer_[k-1];
+    }
+    bitMetrics_[i] = sum;
+  }
+}
+
+/**
+ *  Decodes one bloc of information bits with the min-sum algorithm.
+ *  Check messages are kept in compressed form.
+ *  \param  parity  Input iterator pointing to the first element
+ *    in the parity L-value sequence
+ *  \param  msg[out] Output iterator pointing to the first element
+ *    in the decoded msg sequence.
+ */
+template <class LlrMetrics, template <class> class BoxSumAlg>
+bool BpDecoderImpl<LlrMetrics, BoxSumAlg>::minSumDecodeBlock(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, Codec::Deadline::Clock::time_point deadline)
+{
+  for (size_t i = 0; i < structure().checks().cols(); ++i) {
+    parity_[i] = parity[bitOrder_[i]];
+  }
+  std::fill(checkMin_.begin(), checkMin_.end(), 0);
+  std::fill(checkMinIdx_.begin(), checkMinIdx_.end(), 0);
+  std::fill(checkSigns_.begin(), checkSigns_.end(), 0);
+  std::fill(bitMetrics_.begin(), bitMetrics_.end(), 0);
+  
+  auto message = [this](size_t check, size_t j, size_t edge) {return minSumMessage(check, j, edge);};
+  bool success = false;
+  for (int64_t i = 0; i < int64_t(structure().iterations()) - 1; ++i) {
+    if (Codec::Deadline::isExpired(deadline)) {
+      break;
+    }
+    minSumUpdate(i, message);
+    
+    for (size_t j = 0; j < structure().checks().cols(); ++j) {
+      hardParity_[bitOrder_[j]] = (parity_[j] + bitMetrics_[j] >= 0.0);
+    }
+    if (structure().check(hardParity_.begin())) {
+      success = true;
+      break;
+    }
+  }
+  minSumUpdate(structure().iterations()-1, message);
+  
+  for (size_t i = 0; i < structure().checks().cols(); ++i) {
+    if (bitOrder_[i] < structure().msgSize()) {
+      msg[bitOrder_[i]] = parity_[i] + bitMetrics_[i] >= 0;
+    }
+  }
+  return success;
+}
+
+/**
+ *  Decodes one bloc of information with the min-sum algorithm,
+ *  providing soft output.
+ *  Check messages are kept in compressed form.
+ *  The state is either given by message on each edge,
+ *  or in compact form if required by the structure.
+ *  \param  input  Input iterator pointing to the first element
+ *    of each input sequence
+ *  \param  output[out] Output iterator pointing to the first element
+ *    of each output sequence.
+ */
+template <class LlrMetrics, template <class> class BoxSumAlg>
+void BpDecoderImpl<LlrMetrics, BoxSumAlg>::minSumSoDecodeBlock(Codec::InputIterator input, Codec::OutputIterator output)
+{
+  for (size_t i = 0; i < structure().checks().cols(); ++i) {
+    parity_[i] = input.parity()[bitOrder_[i]];
+  }
+  if (input.hasSyst()) {
+    for (size_t i = 0; i < structure().checks().cols(); ++i) {
+      if (bitOrder_[i] < structure().systSize()) {
+        parity_[i] += input.syst()[bitOrder_[i]];
+      }
+    }
+  }
+  std::fill(checkMin_.begin(), checkMin_.end(), 0);
+  std::fill(checkMinIdx_.begin(), checkMinIdx_.end(), 0);
+  std::fill(checkSigns_.begin(), checkSigns_.end(), 0);
   std::fill(bitMetrics_.begin(), bitMetrics_.end(), 0);
-  for (size_t i = 0; i < structure().checks().size(); ++i) {
-    checkMetricsBuffer_[i] = checkMetrics_[i];
-    auto& ref = bitMetrics_[structure().checks().at(i)];
-    checkMetrics_[i] = ref;
-    ref += checkMetricsBuffer_[i];
+  
+  auto message = [this](size_t check, size_t j, size_t edge) {return minSumMessage(check, j, edge);};
+  auto stateMessage = [&](size_t, size_t, size_t edge) {return typename LlrMetrics::Type(input.state()[edgeOrder_[edge]]);};
+  bool edgeState = false;
+  if (input.hasState()) {
+    if (structure().compactState()) {
+      for (size_t i = 0; i < checkOrder_.size(); ++i) {
+        auto state = input.state() + stateOffsets_[i];
+        checkMin_[2*i] = state[0];
+        checkMin_[2*i+1] = state[1];
+        checkMinIdx_[i] = uint32_t(state[2]);
+        for (size_t j = 0; j < checkEdgeOffsets_[i+1] - checkEdgeOffsets_[i]; ++j) {
+          size_t edge = checkEdgeOffsets_[i] + j;
+          checkSigns_[edge/64] |= uint64_t((uint32_t(state[3+j/32]) >> (j%32)) & 1) << (edge%64);
+        }
+      }
+      minSumBitSum(message);
+    }
+    else {
+      minSumBitSum(stateMessage);
+      edgeState = true;
+    }
   }
+  auto update = [&](size_t i) {
+    if (edgeState) {
+      edgeState = false;
+      minSumUpdate(i, stateMessage);
+    }
+    else {
+      minSumUpdate(i, message);
+    }
+  };
   
-  std::copy(parity_.begin(), parity_.begin() + bitMetrics_.size(), bitMetrics_.begin());
+  for (int64_t i = 0; i < int64_t(structure().iterations()) - 1; ++i) {
+    update(i);
+    
+    for (size_t j = 0; j < structure().checks().cols(); ++j) {
+      hardParity_[bitOrder_[j]] = (parity_[j] + bitMetrics_[j] >= 0.0);
+    }
+    if (structure().check(hardParity_.begin())) {
+      break;
+    }
+  }
+  update(structure().iterations()-1);
   
-  for (int64_t i = structure().checks().size() - 1; i >= 0; --i) {
-    auto& ref = bitMetrics_[structure().checks().at(i)];
-    checkMetrics_[i] += ref;
-    ref += checkMetricsBuffer_[i];
+  for (size_t i = 0; i < structure().checks().cols(); ++i) {
+    size_t j = bitOrder_[i];
+    if (output.hasSyst() && j < structure().systSize()) {
+      output.syst()[j] = bitMetrics_[i];
+    }
+    if (output.hasParity()) {
+      output.parity()[j] = bitMetrics_[i];
+    }
+    if (output.hasMsg() && j < structure().msgSize()) {
+      output.msg()[j] = parity_[i] + bitMetrics_[i];
+    }
+  }
+  if (output.hasState()) {
+    if (structure().compactState()) {
+      for (size_t i = 0; i < checkOrder_.size(); ++i) {
+        auto state = output.state() + stateOffsets_[i];
+        size_t size = checkEdgeOffsets_[i+1] - checkEdgeOffsets_[i];
+        state[0] = checkMin_[2*i];
+        state[1] = checkMin_[2*i+1];
+        state[2] = checkMinIdx_[i];
+        for (size_t k = 0; k < (size+31)/32; ++k) {
+          uint32_t word = 0;
+          for (size_t j = 32*k; j < std::min(size, 32*k+32); ++j) {
+            size_t edge = checkEdgeOffsets_[i] + j;
+            word |= uint32_t((checkSigns_[edge/64] >> (edge%64)) & 1) << (j%32);
+          }
+          state[3+k] = word;
+        }
+      }
+    }
+    else {
+      for (size_t i = 0; i < checkOrder_.size(); ++i) {
+        for (size_t edge = checkEdgeOffsets_[i]; edge < checkEdgeOffsets_[i+1]; ++edge) {
+          output.state()[edgeOrder_[edge]] = minSumMessage(i, edge - checkEdgeOffsets_[i], edge);
+        }
+      }
+    }
+  }
+}
+
+/**
+ *  Updates all check messages and bit metrics with the min-sum algorithm.
+ *  The message sent by each check is described by the two smallest magnitudes
+ *  of its incoming messages, the edge index of the smallest one and the sign bits.
+ *  Incoming messages are computed on the fly from the bit metrics.
+ *  \param  i Iteration index
+ *  \param  message Function giving the previous message sent by a check on one of its edges
+ */
+template <class LlrMetrics, template <class> class BoxSumAlg>
+template <class Message>
+void BpDecoderImpl<LlrMetrics, BoxSumAlg>::minSumUpdate(size_t i, Message message)
+{
+  std::fill(bitMetricsBuffer_.begin(), bitMetricsBuffer_.end(), 0);
+  for (size_t degree = 2; degree < checkGroups_.size(); ++degree) {
+    if (checkGroups_[degree].empty()) {
+      continue;
+    }
+    double sf = structure().scalingFactor(i, degree);
+    for (auto check : checkGroups_[degree]) {
+      const size_t first = checkEdgeOffsets_[check];
+      typename LlrMetrics::Type min1 = llrMetrics_.max();
+      typename LlrMetrics::Type min2 = llrMetrics_.max();
+      size_t minIdx = 0;
+      bool sign = degree % 2;
+      for (size_t j = 0; j < degree; ++j) {
+        const size_t edge = first + j;
+        const size_t bit = edgeBits_[edge];
+        typename LlrMetrics::Type x = parity_[bit] + bitMetrics_[bit] - message(check, j, edge);
+        bool xSign = std::signbit(x);
+        sign ^= xSign;
+        checkSigns_[edge/64] &= ~(uint64_t(1) << (edge%64));
+        checkSigns_[edge/64] |= uint64_t(xSign) << (edge%64);
+        x = std::abs(x);
+        if (x < min1) {
+          min2 = min1;
+          min1 = x;
+          minIdx = j;
+        }
+        else if (x < min2) {
+          min2 = x;
+        }
+      }
+      checkMin_[2*check] = sf * min1;
+      checkMin_[2*check+1] = sf * min2;
+      checkMinIdx_[check] = uint32_t(minIdx);
+      for (size_t j = 0; j < degree; ++j) {
+        const size_t edge = first + j;
+        checkSigns_[edge/64] ^= uint64_t(sign) << (edge%64);
+        bitMetricsBuffer_[edgeBits_[edge]] += minSumMessage(check, j, edge);
+      }
+    }
+  }
+  std::swap(bitMetrics_, bitMetricsBuffer_);
+}
+
+/**
+ *  Computes the bit metrics as the sum of all check messages.
+ *  \param  message Function giving the message sent by a check on one of its edges
+ */
+template <class LlrMetrics, template <class> class BoxSumAlg>
+template <class Message>
+void BpDecoderImpl<LlrMetrics, BoxSumAlg>::minSumBitSum(Message message)
+{
+  std::fill(bitMetrics_.begin(), bitMetrics_.end(), 0);
+  for (size_t i = 0; i < checkOrder_.size(); ++i) {
+    for (size_t edge = checkEdgeOffsets_[i]; edge < checkEdgeOffsets_[i+1]; ++edge) {
+      bitMetrics_[edgeBits_[edge]] += message(i, edge - checkEdgeOffsets_[i], edge);
+    }
   }
 }
 
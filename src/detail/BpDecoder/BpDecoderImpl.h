@@ -24,8 +24,11 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
+#include <stdint.h>
 
 #include "BpDecoder.h"
+#include "../Arena.h"
 
 namespace fec {
   
@@ -45,19 +48,52 @@ namespace fec {
       ~BpDecoderImpl() = default;
       
     protected:
-      virtual void decodeBlock(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg);
+      virtual bool decodeBlock(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, Codec::Deadline::Clock::time_point deadline);
       virtual void soDecodeBlock(Codec::InputIterator input, Codec::OutputIterator output);
       
     private:
       void checkUpdate(size_t i);
+      template <size_t Degree> void checkGroupUpdate(const std::vector<size_t>& checks, size_t degree, double sf);
       void bitUpdate();
       
+      bool minSumDecodeBlock(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, Codec::Deadline::Clock::time_point deadline);
+      void minSumSoDecodeBlock(Codec::InputIterator input, Codec::OutputIterator output);
+      template <class Message> void minSumUpdate(size_t i, Message message);
+      template <class Message> void minSumBitSum(Message message);
+      /**
+       *  Access the compressed message sent by a check on one of its edges.
+       *  \param  check Internal check index
+       *  \param  j Edge index within the check
+       *  \param  edge Internal edge index
+       */
+      inline typename LlrMetrics::Type minSumMessage(size_t check, size_t j, size_t edge) const {
+        typename LlrMetrics::Type x = (j == checkMinIdx_[check]) ? checkMin_[2*check+1] : checkMin_[2*check];
+        return ((checkSigns_[edge/64] >> (edge%64)) & 1) ? -x : x;
+      }
+      
+      static const size_t laneCount_ = 8; /**< Number of checks processed together by check kernels */
+      std::vector<std::vector<size_t>> checkGroups_; /**< Internal check indices, grouped by check degree */
+      std::vector<size_t> checkEdgeOffsets_; /**< Offset of the first edge of each internal check */
+      std::vector<uint32_t> checkOrder_; /**< Row of the check matrix associated with each internal check */
+      AlignedVector<typename LlrMetrics::Type> checkBatch_;
+      std::vector<uint32_t> bitOrder_; /**< Column of the check matrix associated with each internal bit */
+      std::vector<uint32_t> edgeOrder_; /**< Edge of the check matrix associated with each internal edge */
+      std::vector<uint32_t> edgeBits_; /**< Internal bit connected to each internal edge */
+      std::vector<uint32_t> bitEdges_; /**< Edge indices sorted by bit (column-major order) */
+      std::vector<uint32_t> bitEdgeOffsets_; /**< Offset of the first edge of each bit in bitEdges_ */
+      
       std::vector<BitField<size_t>> hardParity_;
       
-      std::vector<typename LlrMetrics::Type> parity_;
-      std::vector<typename LlrMetrics::Type> bitMetrics_;
-      std::vector<typename LlrMetrics::Type> checkMetrics_;
-      std::vector<typename LlrMetrics::Type> checkMetricsBuffer_;
+      AlignedVector<typename LlrMetrics::Type> parity_;
+      AlignedVector<typename LlrMetrics::Type> bitMetrics_;
+      AlignedVector<typename LlrMetrics::Type> checkMetrics_;
+      AlignedVector<typename LlrMetrics::Type> checkMetricsBuffer_;
+      
+      AlignedVector<typename LlrMetrics::Type> checkMin_; /**< Smallest and second smallest message magnitude of each check */
+      AlignedVector<uint32_t> checkMinIdx_; /**< Edge index of the smallest message magnitude within each check */
+      AlignedVector<uint64_t> checkSigns_; /**< Sign bit of the message on each edge */
+      AlignedVector<typename LlrMetrics::Type> bitMetricsBuffer_;
+      std::vector<size_t> stateOffsets_; /**< Offset of the compact state of each internal check */
       
       LlrMetrics llrMetrics_;
       BoxSumAlg<LlrMetrics> boxSum_;
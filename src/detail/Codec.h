@@ -22,6 +22,11 @@
 #ifndef FEC_DETAIL_CODEC_H
 #define FEC_DETAIL_CODEC_H
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <utility>
 #include <vector>
 
 #include <boost/serialization/nvp.hpp>
@@ -56,6 +61,7 @@ namespace fec {
         virtual ~Structure() = default; /**< Default destructor. */
         
         virtual const char * get_key() const = 0; /**< Access the type info key. */
+        virtual Structure* clone() const = 0; /**< Creates a copy of the structure. */
         
         size_t msgSize() const {return msgSize_;} /**< Access the size of msg in each code bloc. */
         size_t systSize() const {return systSize_;} /**< Access the size of systematics in each code bloc. */
@@ -91,6 +97,84 @@ namespace fec {
         void serialize(Archive & ar, const unsigned int version);
       };
       
+      /**
+       *  This class shares a wall-clock budget between the blocks of a batch.
+       *  Each block starting is given an equal share of the time left for the blocks left on its thread,
+       *  such that the time saved by blocks converging early goes to the blocks decoded after them.
+       */
+      class Deadline {
+      public:
+        using Clock = std::chrono::steady_clock;
+        
+        /**
+         *  Constructor.
+         *  \param  end Time at which every block must be decoded
+         *  \param  blockCount Number of blocks in the batch
+         *  \param  workerCount Number of threads decoding the batch
+         */
+        Deadline(Clock::time_point end, size_t blockCount, size_t workerCount) : end_(end), remaining_(blockCount), workerCount_(std::max(workerCount, size_t(1))) {}
+        
+        /**
+         *  Access the deadline of a block starting now.
+         *  Every block needs to call this exactly once, when it starts.
+         *  Without time limit, every block is given the largest time point,
+         *  such that it is decoded exactly as without deadline.
+         */
+        Clock::time_point next() {
+          size_t remaining = std::max(remaining_--, size_t(1));
+          if (end_ == Clock::time_point::max()) {
+            return end_;
+          }
+          auto now = Clock::now();
+          if (now >= end_) {
+            return end_;
+          }
+          auto share = Clock::duration::rep((remaining + workerCount_ - 1) / workerCount_);
+          return now + (end_ - now) / share;
+        }
+        
+        /**
+         *  Checks if a deadline is passed.
+         *  The largest time point never expires and is used when decoding without deadline.
+         */
+        static bool isExpired(Clock::time_point deadline) {return deadline != Clock::time_point::max() && Clock::now() >= deadline;}
+        
+      private:
+        Clock::time_point end_;
+        std::atomic<size_t> remaining_;
+        size_t workerCount_;
+      };
+      
+      /**
+       *  This class holds the decoders of a thread processing a batch of blocks.
+       *  Each decoder is created on first use and kept until the end of the batch,
+       *  such that a thread builds its decoders once instead of once per range of blocks.
+       */
+      class WorkerCache {
+      public:
+        /**
+         *  Access the decoder of a given type, creating it on first use.
+         *  \param  create Function creating the decoder
+         */
+        template <class Decoder, class Create>
+        std::shared_ptr<Decoder> get(Create create) {
+          for (auto& decoder : decoders_) {
+            if (decoder.first == key<Decoder>()) {
+              return std::static_pointer_cast<Decoder>(decoder.second);
+            }
+          }
+          std::shared_ptr<Decoder> decoder(create());
+          decoders_.push_back({key<Decoder>(), decoder});
+          return decoder;
+        }
+        
+      private:
+        template <class Decoder>
+        static const void* key() {static const char key = 0; return &key;}
+        
+        std::vector<std::pair<const void*, std::shared_ptr<void>>> decoders_;
+      };
+      
       /**
        *  This class is an iterator on the codec data flow.
        */
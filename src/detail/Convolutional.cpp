@@ -68,13 +68,45 @@ void Convolutional::Structure::setEncoderOptions(const EncoderOptions& encoder)
 
 void Convolutional::Structure::setDecoderOptions(const DecoderOptions& decoder)
 {
+  if (decoder.windowCount_ == 0) {
+    throw std::invalid_argument("Invalid window count");
+  }
+  if (decoder.radix_ != 2 && decoder.radix_ != 4) {
+    throw std::invalid_argument("Invalid radix");
+  }
   decoderAlgorithm_ = decoder.algorithm_;
   scalingFactor_ = decoder.scalingFactor_;
+  windowCount_ = decoder.windowCount_;
+  radix_ = decoder.radix_;
 }
 
 Convolutional::DecoderOptions Convolutional::Structure::getDecoderOptions() const
 {
-  return DecoderOptions().algorithm(decoderAlgorithm_).scalingFactor(scalingFactor_);
+  return DecoderOptions().algorithm(decoderAlgorithm_).scalingFactor(scalingFactor_).windowCount(windowCount_).radix(radix_);
+}
+
+/**
+ *  Access the structure on which decoders run.
+ *  With radix 4, this is an equivalent structure based on the collapsed trellis.
+ *  Otherwise, this is the structure itself.
+ *  The msg, syst and parity sizes are kept from the original structure,
+ *  and decoders ignore the bits of the collapsed trellis past them.
+ *  When the number of steps is odd, the last collapsed step ends with
+ *  a step of input 0 outside of the block, which keeps a terminated trellis in state 0.
+ *  \return Structure used in decoders
+ */
+Convolutional::Structure Convolutional::Structure::decoderStructure() const
+{
+  Structure structure = *this;
+  size_t stepCount = length() + tailSize();
+  bool isPadded = stepCount % 2 != 0;
+  if (radix() == 4 && (!isPadded || trellis().getNextState(0, 0) == 0)) {
+    structure.trellis_ = trellis().collapse();
+    structure.length_ = (length() + 1) / 2;
+    structure.tailSize_ = (stepCount + 1) / 2 - structure.length_;
+    structure.radix_ = 2;
+  }
+  return structure;
 }
 
 void Convolutional::Structure::encode(std::vector<fec::BitField<size_t>>::const_iterator msg, std::vector<fec::BitField<size_t>>::iterator parity) const
@@ -222,6 +254,12 @@ void Convolutional::Structure::encode(std::vector<fec::BitField<size_t>>::const_
 
 fec::Permutation Convolutional::Structure::puncturing(const PunctureOptions& options) const
 {
+  if (options.mask_.size() == 0 && options.tailMask_.size() == 0) {
+    return Permutation::identity(paritySize());
+  }
+  if (tailSize() == 0 && std::find(options.mask_.begin(), options.mask_.end(), true) != options.mask_.end()) {
+    return Permutation::periodic(options.mask_, paritySize());
+  }
   std::vector<size_t> perms;
   size_t systIdx = 0;
   for (size_t i = 0; i < length() * trellis().outputSize(); ++i) {
@@ -22,6 +22,8 @@
 #ifndef FEC_DETAIL_CONVOLUTIONAL_H
 #define FEC_DETAIL_CONVOLUTIONAL_H
 
+#include <boost/serialization/version.hpp>
+
 #include "Codec.h"
 #include "../BitField.h"
 #include "../Trellis.h"
@@ -52,13 +54,19 @@ namespace fec {
         
         DecoderOptions& algorithm(DecoderAlgorithm algorithm) {algorithm_ = algorithm; return *this;}
         DecoderOptions& scalingFactor(double scalingFactor) {scalingFactor_ = scalingFactor; return *this;}
+        DecoderOptions& windowCount(size_t count) {windowCount_ = count; return *this;}
+        DecoderOptions& radix(size_t radix) {radix_ = radix; return *this;}
         
         DecoderAlgorithm algorithm() const {return algorithm_;}
         double scalingFactor() const {return scalingFactor_;}
+        size_t windowCount() const {return windowCount_;}
+        size_t radix() const {return radix_;}
         
       private:
         DecoderAlgorithm algorithm_ = Approximate;
         double scalingFactor_ = 1.0;
+        size_t windowCount_ = 1;
+        size_t radix_ = 2;
       };
       
       struct PunctureOptions {
@@ -87,6 +95,7 @@ namespace fec {
         virtual ~Structure() = default;
         
         virtual const char * get_key() const;
+        virtual Structure* clone() const {return new Structure(*this);} /**< Creates a copy of the structure. */
         
         void setDecoderOptions(const DecoderOptions& decoder);
         DecoderOptions getDecoderOptions() const;
@@ -99,6 +108,18 @@ namespace fec {
         
         double scalingFactor() const {return scalingFactor_;} /**< Access the scalingFactor value used in decoder. */
         void setScalingFactor(double factor) {scalingFactor_ = factor;} /**< Modify the scalingFactor value used in decoder. */
+        /**
+         *  Access the number of windows in which the trellis is split for a-posteriori decoding.
+         *  Windows are independent and their recursions are interleaved in the decoder.
+         */
+        size_t windowCount() const {return windowCount_;}
+        /**
+         *  Access the radix of the trellis used in decoders.
+         *  With radix 4, decoders run on a collapsed trellis with half as many steps.
+         */
+        size_t radix() const {return radix_;}
+        
+        Structure decoderStructure() const;
         
         virtual bool check(std::vector<BitField<size_t>>::const_iterator parity) const;
         virtual void encode(std::vector<BitField<size_t>>::const_iterator msg, std::vector<BitField<size_t>>::iterator parity) const;
@@ -118,6 +139,8 @@ namespace fec {
         Trellis::Termination termination_;
         size_t tailSize_;
         double scalingFactor_;
+        size_t windowCount_ = 1;
+        size_t radix_ = 2;
       };
       
     }
@@ -129,6 +152,7 @@ namespace fec {
 
 BOOST_CLASS_TYPE_INFO(fec::detail::Convolutional::Structure,extended_type_info_no_rtti<fec::detail::Convolutional::Structure>);
 BOOST_CLASS_EXPORT_KEY(fec::detail::Convolutional::Structure);
+BOOST_CLASS_VERSION(fec::detail::Convolutional::Structure, 1);
 
 
 template <typename Archive>
@@ -140,6 +164,10 @@ void fec::detail::Convolutional::Structure::serialize(Archive & ar, const unsign
   ar & ::BOOST_SERIALIZATION_NVP(tailSize_);
   ar & ::BOOST_SERIALIZATION_NVP(length_);
   ar & ::BOOST_SERIALIZATION_NVP(scalingFactor_);
+  if (version >= 1) {
+    ar & ::BOOST_SERIALIZATION_NVP(windowCount_);
+    ar & ::BOOST_SERIALIZATION_NVP(radix_);
+  }
 }
 
 #endif
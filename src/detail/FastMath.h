@@ -0,0 +1,141 @@
+/*******************************************************************************
+ This file is part of FeCl.
+ 
+ Copyright (c) 2015, Etienne Pierre-Doray, INRS
+ Copyright (c) 2015, Leszek Szczecinski, INRS
+ All rights reserved.
+ 
+ FeCl is free software: you can redistribute it and/or modify
+ it under the terms of the Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ FeCl is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the Lesser General Public License
+ along with FeCl.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#ifndef FEC_DETAIL_FAST_MATH_H
+#define FEC_DETAIL_FAST_MATH_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdint.h>
+
+namespace fec {
+  
+  namespace detail {
+  
+  /*
+   *  The following functions replace the transcendental functions of the exact algorithms.
+   *  They are made of polynomial evaluations, integer manipulations of the exponent
+   *  and selects only, without calls nor branches,
+   *  such that loops over states or edges calling them can be vectorized by the compiler.
+   *  Their relative error to the standard library functions is below 4e-14 over their domain.
+   */
+  
+  inline double toDouble(uint64_t x) {
+    double y;
+    std::memcpy(&y, &x, sizeof(y));
+    return y;
+  }
+  
+  inline uint64_t toBits(double x) {
+    uint64_t y;
+    std::memcpy(&y, &x, sizeof(y));
+    return y;
+  }
+  
+  /**
+   *  Computes exp(x).
+   *  The argument is reduced to x = n*log(2) + r with |r| <= log(2)/2
+   *  and exp(r) is evaluated with its degree 11 Taylor polynomial.
+   *  Results below the smallest normal number are flushed to 0
+   *  and results above exp(709) saturate to infinity.
+   */
+  inline double fastExp(double x) {
+    const double round = 6755399441055744.0; // 2^52 + 2^51
+    double y = std::min(std::max(x, -708.0), 709.0);
+    double t = y * 1.4426950408889634 + round;
+    double n = t - round;
+    double r = (y - n * 6.93147180369123816490e-01) - n * 1.90821492927058770002e-10;
+    
+    double p = 2.505210838544172e-08;
+    p = p * r + 2.755731922398589e-07;
+    p = p * r + 2.7557319223985893e-06;
+    p = p * r + 2.48015873015873e-05;
+    p = p * r + 1.984126984126984e-04;
+    p = p * r + 1.388888888888889e-03;
+    p = p * r + 8.333333333333333e-03;
+    p = p * r + 4.1666666666666664e-02;
+    p = p * r + 1.6666666666666666e-01;
+    p = p * r + 0.5;
+    p = p * r + 1.0;
+    p = p * r + 1.0;
+    
+    double scale = toDouble((toBits(t) + 1023) << 52);
+    double result = p * scale;
+    result = (x < -708.0) ? 0.0 : result;
+    result = (x > 709.0) ? std::numeric_limits<double>::infinity() : result;
+    return result;
+  }
+  
+  /**
+   *  Computes log(x) for positive normal x, 0 and +infinity.
+   *  The argument is reduced to x = 2^k*m with sqrt(1/2) <= m < sqrt(2)
+   *  and log(m) = 2*atanh((m-1)/(m+1)) is evaluated with its odd series up to degree 15.
+   */
+  inline double fastLog(double x) {
+    uint64_t bits = toBits(x);
+    uint64_t offset = bits - 0x3fe6a09e667f3bcdull; // sqrt(1/2)
+    double m = toDouble(bits - (offset & 0xfff0000000000000ull));
+    double k = toDouble(0x4330000000000000ull | ((offset >> 52) ^ 0x800)) - 4503599627372544.0; // 2^52 + 2^11
+    
+    double s = (m - 1.0) / (m + 1.0);
+    double z = s * s;
+    double p = 1.0/15.0;
+    p = p * z + 1.0/13.0;
+    p = p * z + 1.0/11.0;
+    p = p * z + 1.0/9.0;
+    p = p * z + 1.0/7.0;
+    p = p * z + 1.0/5.0;
+    p = p * z + 1.0/3.0;
+    p = p * z + 1.0;
+    
+    double result = k * 6.93147180369123816490e-01 + (k * 1.90821492927058770002e-10 + 2.0 * s * p);
+    result = (x == 0.0) ? -std::numeric_limits<double>::infinity() : result;
+    result = (x == std::numeric_limits<double>::infinity()) ? x : result;
+    return result;
+  }
+  
+  /**
+   *  Computes tanh(x).
+   *  Small arguments use the Taylor polynomial of degree 9 to avoid the cancellation in 1-exp(-2|x|).
+   */
+  inline double fastTanh(double x) {
+    double a = std::abs(x);
+    double e = fastExp(-2.0 * a);
+    double large = (1.0 - e) / (1.0 + e);
+    
+    double z = a * a;
+    double p = 62.0/2835.0;
+    p = p * z - 17.0/315.0;
+    p = p * z + 2.0/15.0;
+    p = p * z - 1.0/3.0;
+    p = p * z + 1.0;
+    double small = a * p;
+    
+    return std::copysign((a < 0.05) ? small : large, x);
+  }
+  
+  }
+  
+}
+
+#endif
@@ -19,6 +19,8 @@
  along with FeCl.  If not, see <http://www.gnu.org/licenses/>.
  ******************************************************************************/
 
+#include <set>
+
 #include "Ldpc.h"
 
 using namespace fec;
@@ -58,7 +60,105 @@ void Ldpc::Structure::setDecoderOptions(const DecoderOptions& decoder)
 {
   decoderAlgorithm_ = decoder.algorithm_;
   iterations_ = decoder.iterations_;
+  graphReordering_ = decoder.graphReordering_;
+  compactState_ = decoder.compactState_;
+  if (compactState_ && decoderAlgorithm_ != Approximate) {
+    throw std::invalid_argument("Compact state requires approximate algorithm");
+  }
+  stateSize_ = checks().size();
+  if (compactState_) {
+    stateSize_ = 0;
+    for (auto check = checks().begin(); check < checks().end(); ++check) {
+      stateSize_ += compactStateSize(check->size());
+    }
+  }
   scalingFactor_ = scalingMapToVector(decoder.scalingFactor_);
+  computeGraphOrdering();
+}
+
+/**
+ *  Computes a bandwidth-reducing ordering of the bipartite graph of the code.
+ *  The ordering is given by a reverse Cuthill-McKee traversal of the graph,
+ *  where bits and checks are both nodes,
+ *  such that neighbouring checks touch neighbouring bits.
+ *  Without graph reordering, checks and bits keep their natural order.
+ */
+void Ldpc::Structure::computeGraphOrdering()
+{
+  const auto& checks = this->checks();
+  checkOrder_.clear();
+  bitOrder_.clear();
+  if (!graphReordering()) {
+    for (size_t i = 0; i < checks.rows(); ++i) {
+      checkOrder_.push_back(uint32_t(i));
+    }
+    for (size_t i = 0; i < checks.cols(); ++i) {
+      bitOrder_.push_back(uint32_t(i));
+    }
+    return;
+  }
+  
+  auto bits = checks.transpose();
+  const size_t cols = checks.cols();
+  const size_t nodeCount = cols + checks.rows();
+  
+  std::vector<size_t> degree(nodeCount);
+  for (size_t i = 0; i < cols; ++i) {
+    degree[i] = bits[i].size();
+  }
+  for (size_t i = 0; i < checks.rows(); ++i) {
+    degree[cols+i] = checks[i].size();
+  }
+  auto byDegree = [&](size_t a, size_t b) {return degree[a] < degree[b];};
+  
+  std::vector<size_t> nodes(nodeCount);
+  for (size_t i = 0; i < nodeCount; ++i) {
+    nodes[i] = i;
+  }
+  std::stable_sort(nodes.begin(), nodes.end(), byDegree);
+  
+  std::vector<size_t> order;
+  order.reserve(nodeCount);
+  std::vector<bool> visited(nodeCount, false);
+  std::vector<size_t> neighbors;
+  for (auto root : nodes) {
+    if (visited[root]) {
+      continue;
+    }
+    visited[root] = true;
+    order.push_back(root);
+    for (size_t i = order.size()-1; i < order.size(); ++i) {
+      size_t node = order[i];
+      neighbors.clear();
+      if (node < cols) {
+        for (auto check : bits[node]) {
+          if (!visited[cols+check]) {
+            visited[cols+check] = true;
+            neighbors.push_back(cols+check);
+          }
+        }
+      }
+      else {
+        for (auto bit : checks[node-cols]) {
+          if (!visited[bit]) {
+            visited[bit] = true;
+            neighbors.push_back(bit);
+          }
+        }
+      }
+      std::stable_sort(neighbors.begin(), neighbors.end(), byDegree);
+      order.insert(order.end(), neighbors.begin(), neighbors.end());
+    }
+  }
+  
+  for (auto node = order.rbegin(); node != order.rend(); ++node) {
+    if (*node < cols) {
+      bitOrder_.push_back(uint32_t(*node));
+    }
+    else {
+      checkOrder_.push_back(uint32_t(*node - cols));
+    }
+  }
 }
 
 std::vector<std::vector<double>> Ldpc::Structure::scalingMapToVector(const std::unordered_map<size_t,std::vector<double>>& map) const
@@ -128,7 +228,7 @@ std::unordered_map<size_t,std::vector<double>> Ldpc::Structure::scalingVectorToM
 
 Ldpc::DecoderOptions Ldpc::Structure::getDecoderOptions() const
 {
-  return DecoderOptions().iterations(iterations()).algorithm(decoderAlgorithm()).scalingFactor(scalingVectorToMap(scalingFactor_));
+  return DecoderOptions().iterations(iterations()).graphReordering(graphReordering()).compactState(compactState()).algorithm(decoderAlgorithm()).scalingFactor(scalingVectorToMap(scalingFactor_));
 }
 
 double Ldpc::Structure::scalingFactor(size_t i, size_t j) const
@@ -138,17 +238,82 @@ double Ldpc::Structure::scalingFactor(size_t i, size_t j) const
 }
 
 /**
- *  Computes the syndrome given a sequence of parity bits.
+ *  Computes the syndrome of up to 64 blocks of parity bits at once.
+ *  Bits of the blocks are packed such that bit k of each word belongs to block k.
+ *  Each check is then computed with one word XOR per element.
  *  \param  parity  Input iterator pointing to the first element of the parity sequence.
- *  \param  syndrome[out] Output iterator pointing to the first
- *    element of the computed syndrome. The output needs to be allocated.
+ *  \param  n Number of blocks, at most 64
+ *  \param  bits Buffer for the packed parity bits
+ *  \param  syndrome[out] Packed syndrome of each check
  */
-void Ldpc::Structure::syndrome(std::vector<uint8_t>::const_iterator parity, std::vector<uint8_t>::iterator syndrome) const
+void Ldpc::Structure::syndromeSlices(std::vector<BitField<size_t>>::const_iterator parity, size_t n, std::vector<uint64_t>& bits, std::vector<uint64_t>& syndrome) const
 {
-  for (auto parityEq = checks().begin(); parityEq < checks().end(); ++parityEq, ++syndrome) {
+  bits.assign(checks().cols(), 0);
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j < checks().cols(); ++j) {
+      bits[j] |= uint64_t(parity[j].test(0)) << i;
+    }
+    parity += paritySize();
+  }
+  syndrome.resize(checks().rows());
+  auto syndromeIt = syndrome.begin();
+  for (auto parityEq = checks().begin(); parityEq < checks().end(); ++parityEq, ++syndromeIt) {
+    uint64_t x = 0;
     for (auto parityBit = parityEq->begin(); parityBit < parityEq->end(); ++parityBit) {
-      *syndrome ^= parity[*parityBit];
+      x ^= bits[*parityBit];
+    }
+    *syndromeIt = x;
+  }
+}
+
+/**
+ *  Computes the syndrome of several blocks of parity bits.
+ *  \param  parity  Input iterator pointing to the first element of the parity sequence.
+ *  \param  syndrome[out] Output iterator pointing to the first
+ *    element of the computed syndrome. The output needs to be allocated
+ *    with one element per check for each block.
+ *  \param  n Number of blocks
+ */
+void Ldpc::Structure::syndrome(std::vector<BitField<size_t>>::const_iterator parity, std::vector<BitField<size_t>>::iterator syndrome, size_t n) const
+{
+  std::vector<uint64_t> bits;
+  std::vector<uint64_t> slices;
+  for (size_t i = 0; i < n; i += 64) {
+    size_t m = std::min(n - i, size_t(64));
+    syndromeSlices(parity, m, bits, slices);
+    for (size_t k = 0; k < m; ++k) {
+      for (size_t j = 0; j < checks().rows(); ++j) {
+        syndrome[j] = (slices[j] >> k) & 1;
+      }
+      syndrome += checks().rows();
+    }
+    parity += m * paritySize();
+  }
+}
+
+/**
+ *  Checks several blocks of parity bits for consistency using their syndrome.
+ *  \param  parity  Input iterator pointing to the first element of the parity sequence.
+ *  \param  result[out] Output iterator pointing to the first element
+ *    of the check result sequence, with 1 for each consistent block and 0 otherwise.
+ *  \param  n Number of blocks
+ */
+void Ldpc::Structure::checkEach(std::vector<BitField<size_t>>::const_iterator parity, std::vector<BitField<size_t>>::iterator result, size_t n) const
+{
+  std::vector<uint64_t> bits;
+  std::vector<uint64_t> slices;
+  for (size_t i = 0; i < n; i += 64) {
+    size_t m = std::min(n - i, size_t(64));
+    syndromeSlices(parity, m, bits, slices);
+    uint64_t failure = 0;
+    for (auto slice : slices) {
+      failure |= slice;
+    }
+    for (size_t k = 0; k < m; ++k) {
+      result[k] = !((failure >> k) & 1);
     }
+    result += m;
+    parity += m * paritySize();
   }
 }
 
@@ -208,6 +373,31 @@ void Ldpc::Structure::encode(std::vector<BitField<size_t>>::const_iterator msg,
   }
 }
 
+/**
+ *  Computes the dense generator matrix of the code.
+ *  Row i is the parity of the msg whose only non-zero bit is i,
+ *  such that the parity of msgs given as the rows of a BitMatrix M is M * G.
+ *  For short codes, this encodes many blocks faster than the sparse encoder.
+ *  \return Generator matrix of msgSize() rows and paritySize() columns
+ */
+BitMatrix Ldpc::Structure::generatorMatrix() const
+{
+  BitMatrix G(msgSize(), paritySize());
+  std::vector<BitField<size_t>> msg(msgSize(), 0);
+  std::vector<BitField<size_t>> parity(paritySize());
+  for (size_t i = 0; i < msgSize(); ++i) {
+    msg[i] = 1;
+    encode(msg.begin(), parity.begin());
+    msg[i] = 0;
+    for (size_t j = 0; j < paritySize(); ++j) {
+      if (parity[j] != 0) {
+        G[i].set(j);
+      }
+    }
+  }
+  return G;
+}
+
 /**
  *  Transforms an ldpc matrix to allow in-place encoding.
  *  The matrix is transformed in a partial triangular shape.
@@ -215,39 +405,81 @@ void Ldpc::Structure::encode(std::vector<BitField<size_t>>::const_iterator msg,
  */
 void Ldpc::Structure::computeGeneratorMatrix(SparseBitMatrix H)
 {
-  std::vector<size_t> colSizes;
   size_t maxRow = H.rows();
   size_t tSize = 0;
   
-  H.colSizes(colSizes);
-  auto colSize = H.end()-1;
+  /*
+   *  Rows and columns are not moved while the triangular part is searched.
+   *  Their positions are tracked instead, and the matrix is rebuilt once.
+   *  The columns of each size are kept ordered by position,
+   *  and the rows of a column are found in the transpose,
+   *  such that each step costs in proportion to the elements involved.
+   */
+  auto Ht = H.transpose();
+  std::vector<size_t> rowIdx(H.rows());
+  std::vector<size_t> rowPos(H.rows());
+  for (size_t i = 0; i < H.rows(); ++i) {
+    rowIdx[i] = i;
+    rowPos[i] = i;
+  }
+  std::vector<size_t> colIdx(H.cols());
+  std::vector<size_t> colPos(H.cols());
+  std::vector<size_t> colSizes(H.cols());
+  std::vector<std::set<size_t>> colsBySize(H.rows()+1);
+  for (size_t j = 0; j < H.cols(); ++j) {
+    colIdx[j] = j;
+    colPos[j] = j;
+    colSizes[j] = Ht[j].size();
+    colsBySize[colSizes[j]].insert(j);
+  }
+  
+  size_t removedRow = H.rows();
+  std::vector<size_t> hits;
   for (size_t i = H.cols(); i > 0; --i) {
-    for (; colSize >= H.begin() + maxRow; --colSize) {
-      for (auto elem = colSize->begin(); elem < colSize->end(); ++elem) {
+    for (; removedRow > maxRow; --removedRow) {
+      auto row = H[rowIdx[removedRow-1]];
+      for (auto elem = row.begin(); elem < row.end(); ++elem) {
+        if (colPos[*elem] < i) {
+          colsBySize[colSizes[*elem]].erase(colPos[*elem]);
+          colsBySize[colSizes[*elem]-1].insert(colPos[*elem]);
+        }
         colSizes[*elem]--;
       }
     }
     size_t minValue = -1;
     size_t minIdx = 0;
-    for (int64_t j = i-1; j >= 0; j--) {
-      if (colSizes[j] == 1) {
-        minIdx = j;
-        minValue = colSizes[j];
+    for (size_t k = 1; k < colsBySize.size(); ++k) {
+      if (!colsBySize[k].empty()) {
+        minValue = k;
+        minIdx = *colsBySize[k].rbegin();
         break;
       }
-      else if (colSizes[j] < minValue && colSizes[j] >= 1) {
-        minIdx = j;
-        minValue = colSizes[j];
+    }
+    size_t a = colIdx[minIdx];
+    size_t b = colIdx[i-1];
+    colsBySize[colSizes[a]].erase(minIdx);
+    colsBySize[colSizes[b]].erase(i-1);
+    if (a != b) {
+      colsBySize[colSizes[b]].insert(minIdx);
+    }
+    std::swap(colIdx[minIdx], colIdx[i-1]);
+    colPos[a] = i-1;
+    colPos[b] = minIdx;
+    
+    hits.clear();
+    for (auto elem = Ht[a].begin(); elem < Ht[a].end(); ++elem) {
+      if (rowPos[*elem] < maxRow) {
+        hits.push_back(rowPos[*elem]);
       }
     }
-    H.swapCols(minIdx, i-1);
-    std::swap(colSizes[minIdx], colSizes[i-1]);
+    std::sort(hits.begin(), hits.end());
     size_t j = maxRow;
-    for (auto row = H.begin(); row < H.begin()+j; ++row) {
-      if (row->test(i-1)) {
+    for (auto row : hits) {
+      while (row < j && H[rowIdx[row]].test(a)) {
         --j;
-        std::swap(H[j], *row);
-        --row;
+        std::swap(rowIdx[row], rowIdx[j]);
+        rowPos[rowIdx[row]] = row;
+        rowPos[rowIdx[j]] = j;
       }
     }
     maxRow -= std::max(minValue, size_t(1));
@@ -257,6 +489,16 @@ void Ldpc::Structure::computeGeneratorMatrix(SparseBitMatrix H)
     }
   }
   
+  SparseBitMatrix::Builder builder(H.rows(), H.cols());
+  builder.reserve(H.size());
+  for (size_t i = 0; i < H.rows(); ++i) {
+    auto row = H[rowIdx[i]];
+    for (auto elem = row.begin(); elem < row.end(); ++elem) {
+      builder.set(i, colPos[*elem]);
+    }
+  }
+  H = builder.matrix();
+  
   for (size_t i = 0; i < tSize; ++i) {
     auto row = H.begin()+i;
     if (!row->test(i+H.cols()-tSize)) {
@@ -280,9 +522,33 @@ void Ldpc::Structure::computeGeneratorMatrix(SparseBitMatrix H)
     }
   }
   
+  /*
+   *  Pivots are eliminated from the other rows by groups with BitMatrix::eliminate.
+   *  Until its group is complete, rows are reduced by the pending pivots
+   *  only when they are searched for the next pivot.
+   */
+  std::vector<size_t> pending;
+  std::vector<size_t> pivotCols;
+  auto reduce = [&](BitMatrix::Row& row) {
+    for (auto k : pending) {
+      if (row.test(k+msgSize())) {
+        row += CDE[k];
+      }
+    }
+  };
+  auto eliminate = [&]() {
+    pivotCols.clear();
+    for (auto k : pending) {
+      pivotCols.push_back(k+msgSize());
+    }
+    CDE.eliminate(pending, pivotCols);
+    pending.clear();
+  };
+  
   for (size_t i = 0; i < CDE.cols()-tSize-msgSize(); ++i) {
     uint8_t found = false;
     for (auto row = CDE.begin()+i; row < CDE.end(); ++row) {
+      reduce(*row);
       if (row->test(i+msgSize())) {
         std::swap(*row, CDE[i]);
         found = true;
@@ -308,20 +574,18 @@ void Ldpc::Structure::computeGeneratorMatrix(SparseBitMatrix H)
       --i;
       continue;
     }
-    for (auto row = CDE.begin()+i+1; row < CDE.end(); ++row) {
-      if (row->test(i+msgSize())) {
-        *row += CDE[i];
+    for (auto k : pending) {
+      if (CDE[k].test(i+msgSize())) {
+        CDE[k] += CDE[i];
       }
     }
-  }
-  
-  for (int64_t i = CDE.rows()-1; i >= 0; --i) {
-    for (auto row = CDE.begin()+i-1; row >= CDE.begin(); --row) {
-      if (row->test(i+msgSize())) {
-        *row += CDE[i];
-      }
+    pending.push_back(i);
+    if (pending.size() == BitMatrix::groupSize()) {
+      eliminate();
     }
   }
+  eliminate();
+  
   //std::cout << H << std::endl;
   H_ = H;
   DC_ = CDE({0, CDE.cols()-msgSize()-tSize}, {0, msgSize()});
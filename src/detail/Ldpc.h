@@ -30,6 +30,7 @@
 #include <unordered_map>
 
 #include <boost/serialization/export.hpp>
+#include <boost/serialization/version.hpp>
 
 #include "Codec.h"
 #include "../BitMatrix.h"
@@ -60,16 +61,22 @@ namespace fec {
         
         DecoderOptions& algorithm(DecoderAlgorithm algorithm) {algorithm_ = algorithm; return *this;}
         DecoderOptions& iterations(size_t n) {iterations_ = n; return *this;}
+        DecoderOptions& graphReordering(bool reorder) {graphReordering_ = reorder; return *this;}
+        DecoderOptions& compactState(bool compact) {compactState_ = compact; return *this;}
         DecoderOptions& scalingFactor(double factor) {scalingFactor_ = {std::make_pair(0, std::vector<double>({factor}))}; return *this;}
         DecoderOptions& scalingFactor(const std::unordered_map<size_t,std::vector<double>>& factor) {scalingFactor_ = factor; return *this;}
         
         DecoderAlgorithm algorithm() const {return algorithm_;}
         size_t iterations() const {return iterations_;}
+        bool graphReordering() const {return graphReordering_;}
+        bool compactState() const {return compactState_;}
         std::unordered_map<size_t,std::vector<double>> scalingFactor() const {return scalingFactor_;}
         
       private:
         DecoderAlgorithm algorithm_ = Approximate;
         size_t iterations_;
+        bool graphReordering_ = false;
+        bool compactState_ = false;
         std::unordered_map<size_t,std::vector<double>> scalingFactor_ = {std::make_pair(0, std::vector<double>({1.0}))};
       };
       
@@ -102,6 +109,7 @@ namespace fec {
         virtual ~Structure() = default;
         
         virtual const char * get_key() const;
+        virtual Structure* clone() const {return new Structure(*this);} /**< Creates a copy of the structure. */
         
         void setDecoderOptions(const DecoderOptions& decoder);
         DecoderOptions getDecoderOptions() const;
@@ -109,11 +117,24 @@ namespace fec {
         
         inline const SparseBitMatrix& checks() const {return H_;}
         inline size_t iterations() const {return iterations_;}
+        inline bool graphReordering() const {return graphReordering_;} /**< Access if the decoder graph is reordered for memory locality. */
+        inline bool compactState() const {return compactState_;} /**< Access if the decoder state is given in compressed min-sum form. */
+        inline const std::vector<uint32_t>& checkOrder() const {return checkOrder_;} /**< Access the check of the structure associated with each decoder position. */
+        inline const std::vector<uint32_t>& bitOrder() const {return bitOrder_;} /**< Access the bit of the structure associated with each decoder position. */
+        /**
+         *  Access the size of the compact state of a check.
+         *  The compact state of a check contains the two smallest message magnitudes,
+         *  the edge index of the smallest one and the message sign bits packed by words of 32 bits.
+         *  \param  degree Check degree
+         */
+        static inline size_t compactStateSize(size_t degree) {return 3 + (degree+31)/32;}
         double scalingFactor(size_t i, size_t j) const; /**< Access the scalingFactor value used in decoder. */
         
-        void syndrome(std::vector<uint8_t>::const_iterator parity, std::vector<uint8_t>::iterator syndrome) const;
+        void syndrome(std::vector<BitField<size_t>>::const_iterator parity, std::vector<BitField<size_t>>::iterator syndrome, size_t n = 1) const;
+        void checkEach(std::vector<BitField<size_t>>::const_iterator parity, std::vector<BitField<size_t>>::iterator result, size_t n) const;
         virtual bool check(std::vector<BitField<size_t>>::const_iterator parity) const;
         virtual void encode(std::vector<BitField<size_t>>::const_iterator msg, std::vector<BitField<size_t>>::iterator parity) const;
+        BitMatrix generatorMatrix() const;
         
       protected:
         void setEncoderOptions(const EncoderOptions& encoder);
@@ -123,6 +144,8 @@ namespace fec {
         void serialize(Archive & ar, const unsigned int version);
         
         void computeGeneratorMatrix(SparseBitMatrix H);
+        void computeGraphOrdering();
+        void syndromeSlices(std::vector<BitField<size_t>>::const_iterator parity, size_t n, std::vector<uint64_t>& bits, std::vector<uint64_t>& syndrome) const;
         std::vector<std::vector<double>> scalingMapToVector(const std::unordered_map<size_t,std::vector<double>>& map) const;
         std::unordered_map<size_t,std::vector<double>> scalingVectorToMap(const std::vector<std::vector<double>>& map) const;
         
@@ -133,7 +156,11 @@ namespace fec {
         SparseBitMatrix B_;
         
         size_t iterations_;
+        bool graphReordering_ = false;
+        bool compactState_ = false;
         std::vector<std::vector<double>> scalingFactor_;
+        std::vector<uint32_t> checkOrder_;
+        std::vector<uint32_t> bitOrder_;
       };
     }
   }
@@ -142,6 +169,7 @@ namespace fec {
 
 
 BOOST_CLASS_EXPORT_KEY(fec::detail::Ldpc::Structure);
+BOOST_CLASS_VERSION(fec::detail::Ldpc::Structure, 1);
 BOOST_CLASS_TYPE_INFO(fec::detail::Ldpc::Structure,extended_type_info_no_rtti<fec::detail::Ldpc::Structure>);
 
 
@@ -155,7 +183,14 @@ void fec::detail::Ldpc::Structure::serialize(Archive & ar, const unsigned int ve
   ar & ::BOOST_SERIALIZATION_NVP(A_);
   ar & ::BOOST_SERIALIZATION_NVP(B_);
   ar & ::BOOST_SERIALIZATION_NVP(iterations_);
+  if (version >= 1) {
+    ar & ::BOOST_SERIALIZATION_NVP(graphReordering_);
+    ar & ::BOOST_SERIALIZATION_NVP(compactState_);
+  }
   ar & ::BOOST_SERIALIZATION_NVP(scalingFactor_);
+  if (Archive::is_loading::value) {
+    computeGraphOrdering();
+  }
 }
 
 #endif
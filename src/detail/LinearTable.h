@@ -22,6 +22,7 @@
 #ifndef FEC_DETAIL_LINEAR_TABLE_H
 #define FEC_DETAIL_LINEAR_TABLE_H
 
+#include <array>
 #include <cmath>
 #include <vector>
 
@@ -29,6 +30,10 @@ namespace fec {
   
   namespace detail {
   
+  /**
+   *  Piece-wise linear interpolation of a function sampled at integers.
+   *  Slopes are precomputed such that an evaluation is one lookup and one multiply-add.
+   */
   template <typename T, size_t length>
   class LinearTable {
   public:
@@ -38,11 +43,19 @@ namespace fec {
       for (size_t i = 0; i < y.size(); ++i) {
         y[i] = f(i);
       }
+      for (size_t i = 0; i + 1 < y.size(); ++i) {
+        slope[i] = y[i+1] - y[i];
+      }
+      slope.back() = 0;
     }
     
+    /**
+     *  Evaluates the interpolated function.
+     *  \param x Argument in [0, length-1]
+     */
     inline T operator () (T x) const {
-      size_t i = x;
-      return (y[i+1] - y[i]) * (x-i) + y[i];
+      int i = int(x);
+      return slope[i] * (x-i) + y[i];
     }
     inline size_t size() const {
       return y.size();
@@ -51,6 +64,7 @@ namespace fec {
   private:
     //std::vector<T> y;
     std::array<T, length> y;
+    std::array<T, length> slope;
   };
   
   template <typename T>
@@ -65,12 +79,16 @@ namespace fec {
       T step_;
     };
     
+    /**
+     *  Evaluates the correction term without branches.
+     *  The argument is clamped to the table before the lookup
+     *  and the correction is selected to 0 beyond the table.
+     */
     inline T operator()(T x) const {
       x *= granularity_;
-      if(x >= table_.size()-1) {
-        return 0;
-      }
-      return table_(x);
+      const T last = T(table_.size()-1);
+      T y = table_((x < last) ? x : last);
+      return (x < last) ? y : T(0);
     }
     
     constexpr static T granularity_ = 2.0;
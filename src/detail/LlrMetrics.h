@@ -29,6 +29,7 @@
 
 #include "../BitField.h"
 #include "LinearTable.h"
+#include "FastMath.h"
 
 #undef max
 
@@ -53,10 +54,7 @@ namespace fec {
       static inline typename LlrMetrics::Type prior(typename LlrMetrics::Type x) {return x;}
       static inline typename LlrMetrics::Type max(typename LlrMetrics::Type a, typename LlrMetrics::Type b) {return std::max(a,b);}
       static inline typename LlrMetrics::Type prior(typename LlrMetrics::Type x, typename LlrMetrics::Type max) {
-        if (x == max) {
-          return 1.0;
-        }
-        return std::exp(x - max);
+        return (x == max) ? 1.0 : fastExp(x - max);
       }
       /**
        * Computes log sum operation.
@@ -64,7 +62,7 @@ namespace fec {
        *  \param  b Right-hand operand.
        */
       static inline typename LlrMetrics::Type sum(typename LlrMetrics::Type a, typename LlrMetrics::Type b) {return a+b;}
-      static inline typename LlrMetrics::Type post(typename LlrMetrics::Type x, typename LlrMetrics::Type max) {return std::log(x) + max;}
+      static inline typename LlrMetrics::Type post(typename LlrMetrics::Type x, typename LlrMetrics::Type max) {return fastLog(x) + max;}
       static inline typename LlrMetrics::Type post(typename LlrMetrics::Type x) {return x;}
       static inline typename LlrMetrics::Type scale(typename LlrMetrics::Type x) {return x;}
     };
@@ -105,10 +103,8 @@ namespace fec {
        *  \param  b Right-hand operand.
        */
       static inline typename LlrMetrics::Type sum(typename LlrMetrics::Type a, typename LlrMetrics::Type b) {
-        if (a == b) {
-          return a;
-        }
-        return std::max(a,b) + log1pexpm(std::abs(a-b));
+        typename LlrMetrics::Type y = std::max(a,b) + log1pexpm(std::abs(a-b));
+        return (a == b) ? a : y;
       }
       static inline typename LlrMetrics::Type prior(typename LlrMetrics::Type x) {return x;}
       static inline typename LlrMetrics::Type post(typename LlrMetrics::Type x) {return x;}
@@ -127,6 +123,7 @@ namespace fec {
     class BoxSum {
     public:
       using isRecursive = std::true_type;
+      using isCompressible = std::false_type;
       
       /**
        * Computes log sum operation.
@@ -134,8 +131,8 @@ namespace fec {
        *  \param  b Right-hand operand.
        */
       static inline typename LlrMetrics::Type sum(typename LlrMetrics::Type a, typename LlrMetrics::Type b) {return a*b;}
-      static inline typename LlrMetrics::Type prior(typename LlrMetrics::Type x) {return tanh(-x/2.0);}
-      static inline typename LlrMetrics::Type post(typename LlrMetrics::Type x) {return -std::log((1.0+x)/(1.0-x));}//{return -2.0*atanh(x);}
+      static inline typename LlrMetrics::Type prior(typename LlrMetrics::Type x) {return fastTanh(-x/2.0);}
+      static inline typename LlrMetrics::Type post(typename LlrMetrics::Type x) {return -fastLog((1.0+x)/(1.0-x));}//{return -2.0*atanh(x);}
       static inline typename LlrMetrics::Type scale(typename LlrMetrics::Type x) {return x;}
     };
     
@@ -143,6 +140,7 @@ namespace fec {
     class LinearBoxSum {
     public:
       using isRecursive = std::true_type;
+      using isCompressible = std::false_type;
       
       /**
        * Computes log sum operation.
@@ -150,12 +148,8 @@ namespace fec {
        *  \param  b Right-hand operand.
        */
       static inline typename LlrMetrics::Type sum(typename LlrMetrics::Type a, typename LlrMetrics::Type b) {
-        if (std::signbit(a) ^ std::signbit(b)) {
-          return std::min(std::abs(a),std::abs(b)) - log1pexpm(std::abs(a+b)) + log1pexpm(std::abs(a-b));
-        }
-        else {
-          return -std::min(std::abs(a),std::abs(b)) - log1pexpm(std::abs(a+b)) + log1pexpm(std::abs(a-b));
-        }
+        typename LlrMetrics::Type min = std::min(std::abs(a),std::abs(b));
+        return -(std::copysign(min, a) * std::copysign(typename LlrMetrics::Type(1), b)) - log1pexpm(std::abs(a+b)) + log1pexpm(std::abs(a-b));
       }
       static inline typename LlrMetrics::Type prior(typename LlrMetrics::Type x) {return x;}
       static inline typename LlrMetrics::Type post(typename LlrMetrics::Type x) {return x;}
@@ -175,6 +169,7 @@ namespace fec {
     class MinBoxSum {
     public:
       using isRecursive = std::true_type;
+      using isCompressible = std::true_type;
       
       /**
        * Computes log sum operation.
@@ -214,6 +209,46 @@ namespace fec {
       return x;
     }
     
+    /**
+     *  Computes the correlations of every sequence of bits of a given size
+     *  with a sequence of L-values.
+     *  Each correlation is built from a previous one by adding a single L-value,
+     *  which computes all 2^size correlations in O(2^size) operations
+     *  with the same results as correlation().
+     *  \param  b Random access input iterator associated with the sequence of L-values
+     *  \param  size  Number of L-values in the sequence
+     *  \param  x[out] Random access output iterator to the correlations, indexed by sequence of bits
+     */
+    template <class LlrMetrics, class InputIterator, class OutputIterator>
+    inline void correlations(InputIterator b, size_t size, OutputIterator x) {
+      x[0] = 0;
+      for (size_t i = 0; i < size; ++i) {
+        typename LlrMetrics::Type llr = typename LlrMetrics::Type(b[i]);
+        size_t count = size_t(1) << i;
+        for (size_t j = 0; j < count; ++j) {
+          x[count + j] = x[j] + llr;
+        }
+      }
+    }
+    
+    /**
+     *  Computes the correlations of every sequence of bits of a given size
+     *  with a sequence of L-values that ends before the bits.
+     *  Missing L-values are taken as 0.
+     *  \param  b Random access input iterator associated with the sequence of L-values
+     *  \param  count  Number of L-values available, at most size
+     *  \param  size  Number of bits in the sequences
+     *  \param  x[out] Random access output iterator to the correlations, indexed by sequence of bits
+     */
+    template <class LlrMetrics, class InputIterator, class OutputIterator>
+    inline void correlations(InputIterator b, size_t count, size_t size, OutputIterator x) {
+      correlations<LlrMetrics>(b, count, x);
+      for (size_t i = count; i < size; ++i) {
+        size_t half = size_t(1) << i;
+        std::copy(x, x + half, x + half);
+      }
+    }
+    
   }
   
 }
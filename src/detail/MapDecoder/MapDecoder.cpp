@@ -25,25 +25,50 @@
 using namespace fec;
 using namespace fec::detail;
 
+namespace {
+  
+  template <class LlrMetrics, template <class> class LogSumAlg>
+  std::unique_ptr<MapDecoder> createImpl(const Convolutional::Structure& structure, TrellisShapeList<>)
+  {
+    return std::unique_ptr<MapDecoder>(new MapDecoderImpl<LlrMetrics, LogSumAlg, DynamicTrellisShape>(structure));
+  }
+  
+  /**
+   *  Creates the decoder specialized for the first shape matching the trellis,
+   *  or the generic decoder if none does.
+   */
+  template <class LlrMetrics, template <class> class LogSumAlg, class Shape, class... Shapes>
+  std::unique_ptr<MapDecoder> createImpl(const Convolutional::Structure& structure, TrellisShapeList<Shape, Shapes...>)
+  {
+    if (Shape::matches(structure.trellis())) {
+      return std::unique_ptr<MapDecoder>(new MapDecoderImpl<LlrMetrics, LogSumAlg, Shape>(structure));
+    }
+    return createImpl<LlrMetrics, LogSumAlg>(structure, TrellisShapeList<Shapes...>());
+  }
+
+}
+
 /**
  *  MapDecoder creator function.
  *  Construct in a factory behavior a MapCodec object corresponding to the algorithm
  *  version in use.
+ *  Trellises with one of the StandardTrellisShapes get a decoder specialized for it.
  *  \param  codeStructure Convolutional code structure describing the code
  *  \return MacDecoder specialization suitable for the algorithm in use
  */
-std::unique_ptr<MapDecoder> MapDecoder::create(const Convolutional::Structure& structure)
+std::unique_ptr<MapDecoder> MapDecoder::create(const Convolutional::Structure& codeStructure)
 {
+  auto structure = codeStructure.decoderStructure();
   switch (structure.decoderAlgorithm()) {
     default:
     case Exact:
-      return std::unique_ptr<MapDecoder>(new MapDecoderImpl<FloatLlrMetrics, LogSum>(structure));
+      return createImpl<FloatLlrMetrics, LogSum>(structure, StandardTrellisShapes());
 
     case Linear:
-      return std::unique_ptr<MapDecoder>(new MapDecoderImpl<FloatLlrMetrics, LinearLogSum>(structure));
+      return createImpl<FloatLlrMetrics, LinearLogSum>(structure, StandardTrellisShapes());
 
     case Approximate:
-      return std::unique_ptr<MapDecoder>(new MapDecoderImpl<FloatLlrMetrics, MaxLogSum>(structure));
+      return createImpl<FloatLlrMetrics, MaxLogSum>(structure, StandardTrellisShapes());
   }
 }
 
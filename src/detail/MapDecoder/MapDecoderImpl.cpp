@@ -29,17 +29,26 @@ using namespace fec::detail;
  *  Allocates metric buffers based on the given code structure.
  *  \param  codeStructure Convolutional code structure describing the code
  */
-template <class LlrMetrics, template <class> class LogSumAlg>
-MapDecoderImpl<LlrMetrics, LogSumAlg>::MapDecoderImpl(const Convolutional::Structure& structure) :
-MapDecoder(structure)
+template <class LlrMetrics, template <class> class LogSumAlg, class Shape>
+MapDecoderImpl<LlrMetrics, LogSumAlg, Shape>::MapDecoderImpl(const Convolutional::Structure& structure) :
+MapDecoder(structure), shape_(structure.trellis())
 {
-  branchMetrics_.resize((this->structure().length()+this->structure().tailSize())*this->structure().trellis().inputCount()*this->structure().trellis().stateCount());
-  forwardMetrics_.resize((this->structure().length()+this->structure().tailSize())*this->structure().trellis().stateCount());
-  backwardMetrics_.resize((this->structure().length()+this->structure().tailSize())*this->structure().trellis().stateCount());
+  branchMetrics_.resize((this->structure().length()+this->structure().tailSize())*shape_.inputCount()*shape_.stateCount());
+  forwardMetrics_.resize((this->structure().length()+this->structure().tailSize())*shape_.stateCount());
+  if (this->structure().windowCount() > 1) {
+    backwardMetrics_.resize((this->structure().length()+this->structure().tailSize())*shape_.stateCount());
+  } else {
+    backwardMetrics_.resize(2 * shape_.stateCount());
+  }
   
-  bufferMetrics_.resize(std::max(this->structure().trellis().outputCount(), this->structure().trellis().inputCount()));
+  size_t bufferSize = std::max(shape_.outputCount(), shape_.inputCount());
   if (!LogSumAlg<LlrMetrics>::isRecursive::value) {
-    bufferMetrics_.resize(this->structure().trellis().stateCount()*(this->structure().trellis().inputCount()+1));
+    bufferSize = std::max(bufferSize, shape_.stateCount()*(shape_.inputCount()+1));
+  }
+  bufferMetrics_.resize(bufferSize);
+  bitMetrics_.resize(4 * (shape_.inputSize() + shape_.outputSize()));
+  if (this->structure().windowCount() > 1) {
+    windowMetrics_.resize(2 * shape_.stateCount() * this->structure().windowCount());
   }
 }
 
@@ -52,8 +61,8 @@ MapDecoder(structure)
  *    in the a posteriori information L-value sequence.
  *    Output needs to be pre-allocated.
  */
-template <class LlrMetrics, template <class> class LogSumAlg>
-void MapDecoderImpl<LlrMetrics, LogSumAlg>::soDecodeBlock(Codec::InputIterator input, Codec::OutputIterator output)
+template <class LlrMetrics, template <class> class LogSumAlg, class Shape>
+void MapDecoderImpl<LlrMetrics, LogSumAlg, Shape>::soDecodeBlock(Codec::InputIterator input, Codec::OutputIterator output)
 {
   soDecodeBlockImpl<double>(input, output);
 }
@@ -67,349 +76,513 @@ void MapDecoderImpl<LlrMetrics, LogSumAlg>::soDecodeBlock(Codec::InputIterator i
  *    in the a posteriori information L-value sequence.
  *    Output needs to be pre-allocated.
  */
-template <class LlrMetrics, template <class> class LogSumAlg>
+template <class LlrMetrics, template <class> class LogSumAlg, class Shape>
 template <class T>
-void MapDecoderImpl<LlrMetrics, LogSumAlg>::soDecodeBlockImpl(Codec::InfoIterator<typename std::vector<T>::const_iterator> input, Codec::InfoIterator<typename std::vector<T>::iterator> output)
+void MapDecoderImpl<LlrMetrics, LogSumAlg, Shape>::soDecodeBlockImpl(Codec::InfoIterator<typename std::vector<T>::const_iterator> input, Codec::InfoIterator<typename std::vector<T>::iterator> output)
 {
   branchUpdate<T>(input);
+  if (structure().windowCount() > 1) {
+    windowDecode<T>(input, output);
+    return;
+  }
   forwardUpdate();
-  backwardUpdate();
-  aPosterioriUpdate<T>(input, output);
+  backwardUpdate<T>(input, output);
+}
+
+/**
+ *  Decodes all windows of the trellis in the calling thread.
+ *  Each window estimates its boundary metrics by running the recursions
+ *  from guardSize() steps outside of the window, which makes windows independent.
+ *  The recursions of all windows advance together, one step at a time,
+ *  such that the independent updates of different windows overlap in the pipeline.
+ *  Branch metrics must be computed beforehand.
+ */
+template <class LlrMetrics, template <class> class LogSumAlg, class Shape>
+template <class T>
+void MapDecoderImpl<LlrMetrics, LogSumAlg, Shape>::windowDecode(Codec::InfoIterator<typename std::vector<T>::const_iterator> input, Codec::InfoIterator<typename std::vector<T>::iterator> output)
+{
+  const size_t stateCount = shape_.stateCount();
+  const size_t tableSize = shape_.tableSize();
+  const size_t windowCount = (stepCount() + windowSize() - 1) / windowSize();
+  auto first = [&](size_t window) {return window * windowSize();};
+  auto last = [&](size_t window) {return std::min(first(window) + windowSize(), stepCount());};
+  auto windowMetric = [&](size_t window) {return windowMetrics_.begin() + window * 2 * stateCount;};
+  
+  for (size_t w = 0; w < windowCount; ++w) {
+    if (first(w) == 0) {
+      windowMetric(w)[0] = 0;
+      std::fill(windowMetric(w)+1, windowMetric(w) + stateCount, -llrMetrics_.max());
+    } else {
+      std::fill(windowMetric(w), windowMetric(w) + stateCount, 0);
+    }
+  }
+  for (size_t g = guardSize(); g > 0; --g) {
+    for (size_t w = 0; w < windowCount; ++w) {
+      if (first(w) >= g) {
+        forwardUpdateImpl(windowMetric(w), branchMetrics_.cbegin() + (first(w) - g) * tableSize, bufferMetrics_.begin());
+        normalize(windowMetric(w) + stateCount);
+        std::copy(windowMetric(w) + stateCount, windowMetric(w) + 2*stateCount, windowMetric(w));
+      }
+    }
+  }
+  for (size_t w = 0; w < windowCount; ++w) {
+    std::copy(windowMetric(w), windowMetric(w) + stateCount, forwardMetrics_.begin() + first(w) * stateCount);
+  }
+  for (size_t j = 0; j + 1 < windowSize(); ++j) {
+    for (size_t w = 0; w < windowCount; ++w) {
+      size_t i = first(w) + j;
+      if (i + 1 < last(w)) {
+        forwardUpdateImpl(forwardMetrics_.begin() + i * stateCount, branchMetrics_.cbegin() + i * tableSize, bufferMetrics_.begin());
+        normalize(forwardMetrics_.begin() + (i+1) * stateCount);
+      }
+    }
+  }
+
+  for (size_t w = 0; w < windowCount; ++w) {
+    if (last(w) == stepCount() && structure().termination() == Trellis::Tail) {
+      windowMetric(w)[stateCount] = 0;
+      std::fill(windowMetric(w) + stateCount + 1, windowMetric(w) + 2*stateCount, -llrMetrics_.max());
+    } else {
+      std::fill(windowMetric(w) + stateCount, windowMetric(w) + 2*stateCount, 0);
+    }
+  }
+  for (size_t g = guardSize(); g > 0; --g) {
+    for (size_t w = 0; w < windowCount; ++w) {
+      if (last(w) + g <= stepCount()) {
+        backwardUpdateImpl(windowMetric(w), branchMetrics_.cbegin() + (last(w) + g - 1) * tableSize, bufferMetrics_.begin());
+        normalize(windowMetric(w));
+        std::copy(windowMetric(w), windowMetric(w) + stateCount, windowMetric(w) + stateCount);
+      }
+    }
+  }
+  for (size_t w = 0; w < windowCount; ++w) {
+    std::copy(windowMetric(w) + stateCount, windowMetric(w) + 2*stateCount, backwardMetrics_.begin() + (last(w)-1) * stateCount);
+  }
+  for (size_t j = 1; j < windowSize(); ++j) {
+    for (size_t w = 0; w < windowCount; ++w) {
+      size_t i = last(w) - 1;
+      if (i >= first(w) + j) {
+        i -= j;
+        backwardUpdateImpl(backwardMetrics_.begin() + i * stateCount, branchMetrics_.cbegin() + (i+1) * tableSize, bufferMetrics_.begin());
+        normalize(backwardMetrics_.begin() + i * stateCount);
+      }
+    }
+  }
+  
+  aPosterioriUpdate<T>(input, output, 0, stepCount());
+}
+
+template <class LlrMetrics, template <class> class LogSumAlg, class Shape>
+void MapDecoderImpl<LlrMetrics, LogSumAlg, Shape>::normalize(typename AlignedVector<typename LlrMetrics::Type>::iterator metric)
+{
+  typename LlrMetrics::Type max = -llrMetrics_.max();
+  for (BitField<size_t> j = 0; j < shape_.stateCount(); ++j) {
+    metric[j] = logSum_.post(metric[j]);
+    max = std::max(metric[j], max);
+  }
+  for (BitField<size_t> j = 0; j < shape_.stateCount(); ++j) {
+    metric[j] -= max;
+  }
 }
 
-template <class LlrMetrics, template <class> class LogSumAlg>
+template <class LlrMetrics, template <class> class LogSumAlg, class Shape>
 template <class T>
-void MapDecoderImpl<LlrMetrics, LogSumAlg>::branchUpdate(Codec::InfoIterator<typename std::vector<T>::const_iterator> input)
+void MapDecoderImpl<LlrMetrics, LogSumAlg, Shape>::branchUpdate(Codec::InfoIterator<typename std::vector<T>::const_iterator> input)
 {
   auto parity = input.parity();
   auto syst = input.syst();
   auto branchMetric = branchMetrics_.begin();
   for (size_t i = 0; i < structure().length() + structure().tailSize(); ++i) {
-    for (BitField<size_t> j = 0; j < structure().trellis().outputCount(); ++j) {
-      bufferMetrics_[j] = correlation<LlrMetrics>(j, parity, structure().trellis().outputSize());
-    }
+    size_t parityCount = std::min(shape_.outputSize(), structure().paritySize() - i * shape_.outputSize());
+    size_t systCount = std::min(shape_.inputSize(), structure().systSize() - i * shape_.inputSize());
+    correlations<LlrMetrics>(parity, parityCount, shape_.outputSize(), bufferMetrics_.begin());
     auto branchMetricTmp = branchMetric;
-    for (auto output = structure().trellis().beginOutput(); output < structure().trellis().endOutput();) {
-      for (size_t k = 0; k < structure().trellis().inputCount(); ++k) {
+    auto output = structure().trellis().beginOutput();
+    for (size_t j = 0; j < shape_.stateCount(); ++j) {
+      for (size_t k = 0; k < shape_.inputCount(); ++k) {
         branchMetric[k] = bufferMetrics_[size_t(output[k])];
       }
-      output += structure().trellis().inputCount();
-      branchMetric += structure().trellis().inputCount();
+      output += shape_.inputCount();
+      branchMetric += shape_.inputCount();
     }
     
     if (input.hasSyst()) {
       branchMetric = branchMetricTmp;
-      for (BitField<size_t> j = 0; j < structure().trellis().inputCount(); ++j) {
-        bufferMetrics_[j] = correlation<LlrMetrics>(j, syst, structure().trellis().inputSize());
-      }
-      for (size_t j = 0; j < structure().trellis().stateCount(); ++j) {
-        for (size_t k = 0; k < structure().trellis().inputCount(); ++k) {
+      correlations<LlrMetrics>(syst, systCount, shape_.inputSize(), bufferMetrics_.begin());
+      for (size_t j = 0; j < shape_.stateCount(); ++j) {
+        for (size_t k = 0; k < shape_.inputCount(); ++k) {
           branchMetric[k] += bufferMetrics_[k];
         }
-        branchMetric += structure().trellis().inputCount();
+        branchMetric += shape_.inputCount();
       }
     }
-    parity += structure().trellis().outputSize();
-    syst += structure().trellis().inputSize();
+    if (systCount < shape_.inputSize()) {
+      branchMetric = branchMetricTmp;
+      for (size_t j = 0; j < shape_.stateCount(); ++j) {
+        for (size_t k = size_t(1) << systCount; k < shape_.inputCount(); ++k) {
+          branchMetric[k] = -llrMetrics_.max();
+        }
+        branchMetric += shape_.inputCount();
+      }
+    }
+    parity += shape_.outputSize();
+    syst += shape_.inputSize();
   }
 }
 
-template <class LlrMetrics, template <class> class LogSumAlg>
-void MapDecoderImpl<LlrMetrics, LogSumAlg>::forwardUpdate()
+template <class LlrMetrics, template <class> class LogSumAlg, class Shape>
+void MapDecoderImpl<LlrMetrics, LogSumAlg, Shape>::forwardUpdate()
 {
   auto forwardMetric = forwardMetrics_.begin();
   auto branchMetric = branchMetrics_.cbegin();
   
   *forwardMetric = 0;
-  std::fill(forwardMetric+1, forwardMetric + structure().trellis().stateCount(), -llrMetrics_.max());
+  std::fill(forwardMetric+1, forwardMetric + shape_.stateCount(), -llrMetrics_.max());
   
-  for (; forwardMetric < forwardMetrics_.end() - structure().trellis().stateCount();) {
-    forwardUpdateImpl(forwardMetric, branchMetric);
-    forwardMetric += structure().trellis().stateCount();
-    branchMetric += structure().trellis().tableSize();
-    typename LlrMetrics::Type max = -llrMetrics_.max();
-    for (BitField<size_t> j = 0; j < structure().trellis().stateCount(); ++j) {
-      forwardMetric[j] = logSum_.post(forwardMetric[j]);
-      max = std::max(forwardMetric[j], max);
-    }
-    for (BitField<size_t> j = 0; j < structure().trellis().stateCount(); ++j) {
-      forwardMetric[j] -= max;
-    }
+  for (; forwardMetric < forwardMetrics_.end() - shape_.stateCount();) {
+    forwardUpdateImpl(forwardMetric, branchMetric, bufferMetrics_.begin());
+    forwardMetric += shape_.stateCount();
+    branchMetric += shape_.tableSize();
+    normalize(forwardMetric);
   }
 }
 
-template <class LlrMetrics, template <class> class LogSumAlg>
-void MapDecoderImpl<LlrMetrics, LogSumAlg>::backwardUpdate()
+/**
+ *  Backward metric calculation fused with the final L-values calculation.
+ *  Only the backward metrics leaving the current step are kept,
+ *  and the L-values of each step are output as soon as they are available.
+ *  Branch and forward metrics must be computed beforehand.
+ */
+template <class LlrMetrics, template <class> class LogSumAlg, class Shape>
+template <class T>
+void MapDecoderImpl<LlrMetrics, LogSumAlg, Shape>::backwardUpdate(Codec::InfoIterator<typename std::vector<T>::const_iterator> input, Codec::InfoIterator<typename std::vector<T>::iterator> output)
 {
-  auto backwardMetric = backwardMetrics_.end()-structure().trellis().stateCount();
+  const size_t stateCount = shape_.stateCount();
+  auto backwardMetric = backwardMetrics_.begin();
   switch (structure().termination()) {
     case Trellis::Tail:
-      *backwardMetric = 0;
-      std::fill(backwardMetric+1, backwardMetric + structure().trellis().stateCount(), -llrMetrics_.max());
+      backwardMetric[stateCount] = 0;
+      std::fill(backwardMetric + stateCount + 1, backwardMetric + 2*stateCount, -llrMetrics_.max());
       break;
       
     default:
     case Trellis::Truncate:
-      std::fill(backwardMetric, backwardMetric + structure().trellis().stateCount(), 0.0);
+      std::fill(backwardMetric + stateCount, backwardMetric + 2*stateCount, 0.0);
       break;
   }
-  backwardMetric -= structure().trellis().stateCount();
-  auto branchMetric = branchMetrics_.cend()-structure().trellis().tableSize();
   
-  for ( ; backwardMetric >= backwardMetrics_.begin();) {
-    backwardUpdateImpl(backwardMetric, branchMetric);
-    typename LlrMetrics::Type max = -llrMetrics_.max();
-    for (BitField<size_t> j = 0; j < structure().trellis().stateCount(); ++j) {
-      backwardMetric[j] = logSum_.post(backwardMetric[j]);
-      max = std::max(backwardMetric[j], max);
-    }
-    for (BitField<size_t> j = 0; j < structure().trellis().stateCount(); ++j) {
-      backwardMetric[j] -= max;
+  for (size_t i = stepCount(); i > 0; --i) {
+    auto branchMetric = branchMetrics_.begin() + (i-1) * shape_.tableSize();
+    if (i > 1) {
+      backwardUpdateImpl(backwardMetric, branchMetric, bufferMetrics_.begin());
+      normalize(backwardMetric);
     }
-    backwardMetric -= structure().trellis().stateCount();
-    branchMetric -= structure().trellis().tableSize();
+    aPosterioriStep<T>(input, output, i-1, branchMetric, forwardMetrics_.cbegin() + (i-1) * stateCount, backwardMetric + stateCount, bitMetrics_.begin());
+    std::copy(backwardMetric, backwardMetric + stateCount, backwardMetric + stateCount);
   }
 }
 
-template <class LlrMetrics, template <class> class LogSumAlg>
+template <class LlrMetrics, template <class> class LogSumAlg, class Shape>
 template <typename T>
-void MapDecoderImpl<LlrMetrics, LogSumAlg>::aPosterioriUpdate(Codec::InfoIterator<typename std::vector<T>::const_iterator> input, Codec::InfoIterator<typename std::vector<T>::iterator> output)
+void MapDecoderImpl<LlrMetrics, LogSumAlg, Shape>::aPosterioriUpdate(Codec::InfoIterator<typename std::vector<T>::const_iterator> input, Codec::InfoIterator<typename std::vector<T>::iterator> output, size_t first, size_t last)
 {
-  auto systOut = output.syst();
-  auto systIn = input.syst();
-  auto parityOut = output.parity();
-  auto parityIn = input.parity();
-  auto msgOut = output.msg();
-
-  for (size_t i = 0; i < structure().length() + structure().tailSize(); ++i) {
-    auto branchMetric = branchMetrics_.begin() + i * structure().trellis().tableSize();
-    auto forwardMetric = forwardMetrics_.cbegin() + i * structure().trellis().stateCount();
-    auto backwardMetric = backwardMetrics_.cbegin() + i * structure().trellis().stateCount();
-    
-    for (auto state = structure().trellis().beginState(); state < structure().trellis().endState(); ) {
-      for (BitField<size_t> input = 0; input < structure().trellis().inputCount(); ++input) {
-        branchMetric[input] = logSum_.prior(branchMetric[input] + *forwardMetric + backwardMetric[size_t(state[input])]);
-      }
-      state += structure().trellis().inputCount();
-      branchMetric += structure().trellis().inputCount();
-      ++forwardMetric;
-    }
-    
-    if (output.hasSyst() || (output.hasMsg() && i < structure().length())) {
-      for (size_t j = 0; j < structure().trellis().inputSize(); ++j) {
-        branchMetric = branchMetrics_.begin() + i * structure().trellis().tableSize();
-        typename LlrMetrics::Type tmp = msgUpdateImpl(branchMetric, j);
+  for (size_t i = first; i < last; ++i) {
+    aPosterioriStep<T>(input, output, i,
+                       branchMetrics_.begin() + i * shape_.tableSize(),
+                       forwardMetrics_.cbegin() + i * shape_.stateCount(),
+                       backwardMetrics_.cbegin() + i * shape_.stateCount(),
+                       bitMetrics_.begin());
+  }
+}
 
-        if (output.hasSyst()) {
-          if (input.hasSyst()) {
-            systOut[j] = structure().scalingFactor() * (tmp - systIn[j]);
-          }
-          else {
-            systOut[j] = structure().scalingFactor() * (tmp);
-          }
+/**
+ *  Computes and outputs the final L-values of one step.
+ *  \param  i Step index
+ *  \param  branchMetric  Branch metrics (gamma) of the step
+ *  \param  forwardMetric Forward metrics (alpha) entering the step
+ *  \param  backwardMetric  Backward metrics (beta) leaving the step
+ *  \param  bitMetric Buffer of 4*(inputSize+outputSize) metrics
+ */
+template <class LlrMetrics, template <class> class LogSumAlg, class Shape>
+template <typename T>
+void MapDecoderImpl<LlrMetrics, LogSumAlg, Shape>::aPosterioriStep(Codec::InfoIterator<typename std::vector<T>::const_iterator> input, Codec::InfoIterator<typename std::vector<T>::iterator> output, size_t i, typename AlignedVector<typename LlrMetrics::Type>::iterator branchMetric, typename AlignedVector<typename LlrMetrics::Type>::const_iterator forwardMetric, typename AlignedVector<typename LlrMetrics::Type>::const_iterator backwardMetric, typename AlignedVector<typename LlrMetrics::Type>::iterator bitMetric)
+{
+  const size_t inputSize = shape_.inputSize();
+  const size_t outputSize = shape_.outputSize();
+  bool hasInput = output.hasSyst() || (output.hasMsg() && i < structure().length());
+  const size_t systCount = std::min(inputSize, structure().systSize() - i * inputSize);
+  const size_t msgCount = (i < structure().length()) ? std::min(inputSize, structure().msgSize() - i * inputSize) : 0;
+  if (!hasInput && !output.hasParity()) {
+    return;
+  }
+  aPosterioriImpl(branchMetric, forwardMetric, backwardMetric, bitMetric, output.hasParity());
+  
+  if (hasInput) {
+    size_t offset = i * inputSize;
+    auto systIn = input.syst();
+    auto systOut = output.syst();
+    auto msgOut = output.msg();
+    for (size_t j = 0; j < systCount; ++j) {
+      typename LlrMetrics::Type tmp = bitMetric[j];
+  
+      if (output.hasSyst()) {
+        if (input.hasSyst()) {
+          systOut[offset+j] = structure().scalingFactor() * (tmp - systIn[offset+j]);
         }
-        if (output.hasMsg() && i < structure().length()) {
-          msgOut[j] = structure().scalingFactor() * (tmp);
+        else {
+          systOut[offset+j] = structure().scalingFactor() * (tmp);
         }
       }
-      systIn += structure().trellis().inputSize();
-      systOut += structure().trellis().inputSize();
-      msgOut += structure().trellis().inputSize();
+      if (output.hasMsg() && j < msgCount) {
+        msgOut[offset+j] = structure().scalingFactor() * (tmp);
+      }
     }
-    if (output.hasParity()) {
-      for (size_t j = 0; j < structure().trellis().outputSize(); ++j) {
-        branchMetric = branchMetrics_.begin() + i * structure().trellis().tableSize();
-        typename LlrMetrics::Type tmp = parityUpdateImpl(branchMetric, j);
-        
-        if (input.hasParity()) {
-          parityOut[j] = structure().scalingFactor() * (tmp - parityIn[j]);
-        }
-        else {
-          parityOut[j] = structure().scalingFactor() * (tmp);
-        }
+  }
+  if (output.hasParity()) {
+    size_t offset = i * outputSize;
+    auto parityIn = input.parity();
+    auto parityOut = output.parity();
+    for (size_t j = 0; j < std::min(outputSize, structure().paritySize() - offset); ++j) {
+      typename LlrMetrics::Type tmp = bitMetric[inputSize + j];
+  
+      if (input.hasParity()) {
+        parityOut[offset+j] = structure().scalingFactor() * (tmp - parityIn[offset+j]);
+      }
+      else {
+        parityOut[offset+j] = structure().scalingFactor() * (tmp);
       }
-      parityIn += structure().trellis().outputSize();
-      parityOut += structure().trellis().outputSize();
     }
   }
 }
 
-template <class LlrMetrics, template <class> class LogSumAlg>
+template <class LlrMetrics, template <class> class LogSumAlg, class Shape>
 template <class U, typename std::enable_if<U::value>::type*>
-void MapDecoderImpl<LlrMetrics, LogSumAlg>::forwardUpdateImpl(typename std::vector<typename LlrMetrics::Type>::iterator forwardMetric, typename std::vector<typename LlrMetrics::Type>::const_iterator branchMetric)
+void MapDecoderImpl<LlrMetrics, LogSumAlg, Shape>::forwardUpdateImpl(typename AlignedVector<typename LlrMetrics::Type>::iterator forwardMetric, typename AlignedVector<typename LlrMetrics::Type>::const_iterator branchMetric, typename AlignedVector<typename LlrMetrics::Type>::iterator)
 {
-  std::fill(forwardMetric + structure().trellis().stateCount(), forwardMetric + 2*structure().trellis().stateCount(), logSum_.prior(-llrMetrics_.max()));
-  auto state = structure().trellis().beginState();
-  for (BitField<size_t> j = 0; j < structure().trellis().stateCount(); ++j) {
-    for (BitField<size_t> k = 0; k < structure().trellis().inputCount(); ++k) {
-      auto & forwardMetricRef = forwardMetric[structure().trellis().stateCount() + size_t(state[k])];
-      forwardMetricRef =
-      logSum_.sum(forwardMetricRef, logSum_.prior(forwardMetric[j] + branchMetric[k]));
+  if (!structure().trellis().hasPredecessors()) {
+    std::fill(forwardMetric + shape_.stateCount(), forwardMetric + 2*shape_.stateCount(), logSum_.prior(-llrMetrics_.max()));
+    auto state = structure().trellis().beginState();
+    for (BitField<size_t> j = 0; j < shape_.stateCount(); ++j) {
+      for (BitField<size_t> k = 0; k < shape_.inputCount(); ++k) {
+        auto & forwardMetricRef = forwardMetric[shape_.stateCount() + size_t(state[k])];
+        forwardMetricRef = logSum_.sum(forwardMetricRef, logSum_.prior(forwardMetric[j] + branchMetric[k]));
+      }
+      branchMetric += shape_.inputCount();
+      state += shape_.inputCount();
     }
-    branchMetric += structure().trellis().inputCount();
-    state += structure().trellis().inputCount();
+    return;
+  }
+  auto previousState = structure().trellis().beginPreviousState();
+  auto previousInput = structure().trellis().beginPreviousInput();
+  const size_t inputCount = shape_.inputCount();
+  for (size_t j = 0; j < shape_.stateCount(); ++j) {
+    typename LlrMetrics::Type metric = logSum_.prior(-llrMetrics_.max());
+    for (size_t k = 0; k < inputCount; ++k) {
+      size_t state = previousState[k];
+      metric = logSum_.sum(metric, logSum_.prior(forwardMetric[state] + branchMetric[state * inputCount + previousInput[k]]));
+    }
+    forwardMetric[shape_.stateCount() + j] = metric;
+    previousState += inputCount;
+    previousInput += inputCount;
   }
 }
 
-template <class LlrMetrics, template <class> class LogSumAlg>
+template <class LlrMetrics, template <class> class LogSumAlg, class Shape>
 template <class U, typename std::enable_if<!U::value>::type*>
-void MapDecoderImpl<LlrMetrics, LogSumAlg>::forwardUpdateImpl(typename std::vector<typename LlrMetrics::Type>::iterator forwardMetric, typename std::vector<typename LlrMetrics::Type>::const_iterator branchMetric)
+void MapDecoderImpl<LlrMetrics, LogSumAlg, Shape>::forwardUpdateImpl(typename AlignedVector<typename LlrMetrics::Type>::iterator forwardMetric, typename AlignedVector<typename LlrMetrics::Type>::const_iterator branchMetric, typename AlignedVector<typename LlrMetrics::Type>::iterator bufferMetric)
 {
-  auto state = structure().trellis().beginState();
-  auto bufferMetric = bufferMetrics_.begin();
-  auto maxMetric = bufferMetric + structure().trellis().stateCount()*structure().trellis().inputCount();
-  std::fill(maxMetric, maxMetric + structure().trellis().stateCount(), -llrMetrics_.max());
-  for (BitField<size_t> j = 0; j < structure().trellis().stateCount(); ++j) {
-    for (BitField<size_t> k = 0; k < structure().trellis().inputCount(); ++k) {
-      bufferMetric[k] = forwardMetric[j] + branchMetric[k];
-      maxMetric[size_t(state[k])] = logSum_.max(bufferMetric[k], maxMetric[size_t(state[k])]);
+  if (!structure().trellis().hasPredecessors()) {
+    auto state = structure().trellis().beginState();
+    auto maxMetric = bufferMetric + shape_.tableSize();
+    std::fill(maxMetric, maxMetric + shape_.stateCount(), -llrMetrics_.max());
+    for (BitField<size_t> j = 0; j < shape_.stateCount(); ++j) {
+      for (BitField<size_t> k = 0; k < shape_.inputCount(); ++k) {
+        bufferMetric[j * shape_.inputCount() + k] = forwardMetric[j] + branchMetric[k];
+        maxMetric[size_t(state[k])] = logSum_.max(bufferMetric[j * shape_.inputCount() + k], maxMetric[size_t(state[k])]);
+      }
+      branchMetric += shape_.inputCount();
+      state += shape_.inputCount();
+    }
+    forwardMetric += shape_.stateCount();
+    std::fill(forwardMetric, forwardMetric + shape_.stateCount(), 0);
+    state = structure().trellis().beginState();
+    for (BitField<size_t> j = 0; j < shape_.stateCount(); ++j) {
+      for (BitField<size_t> k = 0; k < shape_.inputCount(); ++k) {
+        auto metric = logSum_.prior(bufferMetric[j * shape_.inputCount() + k], maxMetric[size_t(state[k])]);
+        forwardMetric[size_t(state[k])] = logSum_.sum(metric, forwardMetric[size_t(state[k])]);
+      }
+      state += shape_.inputCount();
     }
-    branchMetric += structure().trellis().inputCount();
-    bufferMetric += structure().trellis().inputCount();
-    state += structure().trellis().inputCount();
-  }
-  forwardMetric += structure().trellis().stateCount();
-  std::fill(forwardMetric, forwardMetric + structure().trellis().stateCount(), 0);
-  state = structure().trellis().beginState();
-  bufferMetric = bufferMetrics_.begin();
-  for (BitField<size_t> j = 0; j < structure().trellis().stateCount(); ++j) {
-    for (BitField<size_t> k = 0; k < structure().trellis().inputCount(); ++k) {
-      bufferMetric[k] = logSum_.prior(bufferMetric[k], maxMetric[size_t(state[k])]);
-      forwardMetric[size_t(state[k])] = logSum_.sum(bufferMetric[k], forwardMetric[size_t(state[k])]);
+    for (BitField<size_t> j = 0; j < shape_.stateCount(); ++j) {
+      forwardMetric[j] = logSum_.post(forwardMetric[j], maxMetric[j]);
     }
-    bufferMetric += structure().trellis().inputCount();
-    state += structure().trellis().inputCount();
+    return;
   }
-  for (BitField<size_t> j = 0; j < structure().trellis().stateCount(); ++j) {
-    forwardMetric[j] = logSum_.post(forwardMetric[j], maxMetric[j]);
+  auto previousState = structure().trellis().beginPreviousState();
+  auto previousInput = structure().trellis().beginPreviousInput();
+  const size_t inputCount = shape_.inputCount();
+  for (size_t j = 0; j < shape_.stateCount(); ++j) {
+    typename LlrMetrics::Type max = -llrMetrics_.max();
+    for (size_t k = 0; k < inputCount; ++k) {
+      size_t state = previousState[k];
+      bufferMetric[k] = forwardMetric[state] + branchMetric[state * inputCount + previousInput[k]];
+      max = logSum_.max(bufferMetric[k], max);
+    }
+    typename LlrMetrics::Type metric = 0;
+    for (size_t k = 0; k < inputCount; ++k) {
+      metric = logSum_.sum(logSum_.prior(bufferMetric[k], max), metric);
+    }
+    forwardMetric[shape_.stateCount() + j] = logSum_.post(metric, max);
+    previousState += inputCount;
+    previousInput += inputCount;
   }
 }
 
-template <class LlrMetrics, template <class> class LogSumAlg>
+template <class LlrMetrics, template <class> class LogSumAlg, class Shape>
 template <class U, typename std::enable_if<U::value>::type*>
-void MapDecoderImpl<LlrMetrics, LogSumAlg>::backwardUpdateImpl(typename std::vector<typename LlrMetrics::Type>::iterator backwardMetric, typename std::vector<typename LlrMetrics::Type>::const_iterator branchMetric)
+void MapDecoderImpl<LlrMetrics, LogSumAlg, Shape>::backwardUpdateImpl(typename AlignedVector<typename LlrMetrics::Type>::iterator backwardMetric, typename AlignedVector<typename LlrMetrics::Type>::const_iterator branchMetric, typename AlignedVector<typename LlrMetrics::Type>::iterator)
 {
-  std::fill(backwardMetric, backwardMetric + structure().trellis().stateCount(), logSum_.prior(-llrMetrics_.max()));
+  std::fill(backwardMetric, backwardMetric + shape_.stateCount(), logSum_.prior(-llrMetrics_.max()));
   auto state = structure().trellis().beginState();
-  for (BitField<size_t> j = 0; j < structure().trellis().stateCount(); ++j) {
-    for (BitField<size_t> k = 0; k < structure().trellis().inputCount(); ++k) {
+  for (BitField<size_t> j = 0; j < shape_.stateCount(); ++j) {
+    for (BitField<size_t> k = 0; k < shape_.inputCount(); ++k) {
       backwardMetric[j] =
       logSum_.sum(
              backwardMetric[j],
-             logSum_.prior(backwardMetric[size_t(state[k])+structure().trellis().stateCount()] + branchMetric[k])
+             logSum_.prior(backwardMetric[size_t(state[k])+shape_.stateCount()] + branchMetric[k])
              );
     }
-    branchMetric += structure().trellis().inputCount();
-    state += structure().trellis().inputCount();
+    branchMetric += shape_.inputCount();
+    state += shape_.inputCount();
   }
 }
 
-template <class LlrMetrics, template <class> class LogSumAlg>
+template <class LlrMetrics, template <class> class LogSumAlg, class Shape>
 template <class U, typename std::enable_if<!U::value>::type*>
-void MapDecoderImpl<LlrMetrics, LogSumAlg>::backwardUpdateImpl(typename std::vector<typename LlrMetrics::Type>::iterator backwardMetric, typename std::vector<typename LlrMetrics::Type>::const_iterator branchMetric)
+void MapDecoderImpl<LlrMetrics, LogSumAlg, Shape>::backwardUpdateImpl(typename AlignedVector<typename LlrMetrics::Type>::iterator backwardMetric, typename AlignedVector<typename LlrMetrics::Type>::const_iterator branchMetric, typename AlignedVector<typename LlrMetrics::Type>::iterator bufferMetric)
 {
   auto state = structure().trellis().beginState();
-  auto bufferMetric = bufferMetrics_.begin();
-  std::fill(backwardMetric, backwardMetric + structure().trellis().stateCount(), 0);
-  for (BitField<size_t> j = 0; j < structure().trellis().stateCount(); ++j) {
+  std::fill(backwardMetric, backwardMetric + shape_.stateCount(), 0);
+  for (BitField<size_t> j = 0; j < shape_.stateCount(); ++j) {
     typename LlrMetrics::Type max = -llrMetrics_.max();
-    for (BitField<size_t> k = 0; k < structure().trellis().inputCount(); ++k) {
-      bufferMetric[k] = backwardMetric[size_t(state[k])+structure().trellis().stateCount()] + branchMetric[k];
+    for (BitField<size_t> k = 0; k < shape_.inputCount(); ++k) {
+      bufferMetric[k] = backwardMetric[size_t(state[k])+shape_.stateCount()] + branchMetric[k];
       max = logSum_.max(bufferMetric[k], max);
     }
-    for (BitField<size_t> k = 0; k < structure().trellis().inputCount(); ++k) {
+    for (BitField<size_t> k = 0; k < shape_.inputCount(); ++k) {
       bufferMetric[k] = logSum_.prior(bufferMetric[k], max);
       backwardMetric[j] = logSum_.sum(bufferMetric[k], backwardMetric[j]);
     }
     backwardMetric[j] = logSum_.post(backwardMetric[j], max);
-    branchMetric += structure().trellis().inputCount();
-    bufferMetric += structure().trellis().inputCount();
-    state += structure().trellis().inputCount();
+    branchMetric += shape_.inputCount();
+    bufferMetric += shape_.inputCount();
+    state += shape_.inputCount();
   }
 }
 
-template <class LlrMetrics, template <class> class LogSumAlg>
+/**
+ *  Computes the L-values of every input bits followed by every output bits of one step
+ *  in a single pass over the branches.
+ *  The metric of bit j with value b is accumulated in bitMetric[2*j+b]
+ *  before the L-value of bit j is written to bitMetric[j].
+ */
+template <class LlrMetrics, template <class> class LogSumAlg, class Shape>
 template <class U, typename std::enable_if<U::value>::type*>
-typename LlrMetrics::Type MapDecoderImpl<LlrMetrics, LogSumAlg>::msgUpdateImpl(typename std::vector<typename LlrMetrics::Type>::iterator branchMetric, size_t j)
+void MapDecoderImpl<LlrMetrics, LogSumAlg, Shape>::aPosterioriImpl(typename AlignedVector<typename LlrMetrics::Type>::iterator branchMetric, typename AlignedVector<typename LlrMetrics::Type>::const_iterator forwardMetric, typename AlignedVector<typename LlrMetrics::Type>::const_iterator backwardMetric, typename AlignedVector<typename LlrMetrics::Type>::iterator bitMetric, bool hasParity)
 {
-  typename LlrMetrics::Type metric[2] = {logSum_.prior(-llrMetrics_.max()), logSum_.prior(-llrMetrics_.max())};
-  for (size_t k = 0; k < structure().trellis().stateCount(); ++k) {
-    for (BitField<size_t> input = 0; input < structure().trellis().inputCount(); ++input) {
-      metric[input.test(j)] = logSum_.sum(metric[input.test(j)], branchMetric[input]);
+  const size_t inputSize = shape_.inputSize();
+  const size_t bitCount = inputSize + (hasParity ? shape_.outputSize() : 0);
+  std::fill(bitMetric, bitMetric + 2*bitCount, logSum_.prior(-llrMetrics_.max()));
+  
+  auto state = structure().trellis().beginState();
+  auto output = structure().trellis().beginOutput();
+  for (size_t k = 0; k < shape_.stateCount(); ++k) {
+    for (BitField<size_t> input = 0; input < shape_.inputCount(); ++input) {
+      typename LlrMetrics::Type metric = logSum_.prior(branchMetric[input] + forwardMetric[k] + backwardMetric[size_t(state[input])]);
+      for (size_t j = 0; j < inputSize; ++j) {
+        size_t idx = 2*j + input.test(j);
+        bitMetric[idx] = logSum_.sum(bitMetric[idx], metric);
+      }
+      for (size_t j = inputSize; j < bitCount; ++j) {
+        size_t idx = 2*j + output[input].test(j-inputSize);
+        bitMetric[idx] = logSum_.sum(bitMetric[idx], metric);
+      }
     }
-    branchMetric += structure().trellis().inputCount();
+    branchMetric += shape_.inputCount();
+    state += shape_.inputCount();
+    output += shape_.inputCount();
   }
-  return logSum_.post(metric[1]) - logSum_.post(metric[0]);
-}
-
-template <class LlrMetrics, template <class> class LogSumAlg>
-template <class U, typename std::enable_if<U::value>::type*>
-typename LlrMetrics::Type MapDecoderImpl<LlrMetrics, LogSumAlg>::parityUpdateImpl(typename std::vector<typename LlrMetrics::Type>::iterator branchMetric, size_t j)
-{
-  typename LlrMetrics::Type metric[2] = {logSum_.prior(-llrMetrics_.max()), logSum_.prior(-llrMetrics_.max())};
-  for (auto output = structure().trellis().beginOutput(); output < structure().trellis().endOutput();) {
-    for (BitField<size_t> input = 0; input < structure().trellis().inputCount(); ++input) {
-      metric[output[input].test(j)] = logSum_.sum(metric[output[input].test(j)], branchMetric[input]);
-    }
-    branchMetric += structure().trellis().inputCount();
-    output += structure().trellis().inputCount();
+  for (size_t j = 0; j < bitCount; ++j) {
+    bitMetric[j] = logSum_.post(bitMetric[2*j+1]) - logSum_.post(bitMetric[2*j]);
   }
-  return logSum_.post(metric[1]) - logSum_.post(metric[0]);
 }
 
-template <class LlrMetrics, template <class> class LogSumAlg>
+/**
+ *  Computes the L-values of every input bits followed by every output bits of one step.
+ *  The first pass over the branches stores the a posteriori branch metrics
+ *  and finds the maximum metric of each bit value,
+ *  the second pass accumulates the metrics relative to these maxima.
+ */
+template <class LlrMetrics, template <class> class LogSumAlg, class Shape>
 template <class U, typename std::enable_if<!U::value>::type*>
-typename LlrMetrics::Type MapDecoderImpl<LlrMetrics, LogSumAlg>::msgUpdateImpl(typename std::vector<typename LlrMetrics::Type>::iterator branchMetric, size_t j)
+void MapDecoderImpl<LlrMetrics, LogSumAlg, Shape>::aPosterioriImpl(typename AlignedVector<typename LlrMetrics::Type>::iterator branchMetric, typename AlignedVector<typename LlrMetrics::Type>::const_iterator forwardMetric, typename AlignedVector<typename LlrMetrics::Type>::const_iterator backwardMetric, typename AlignedVector<typename LlrMetrics::Type>::iterator bitMetric, bool hasParity)
 {
-  typename LlrMetrics::Type max[2] = {typename LlrMetrics::Type(-llrMetrics_.max()), typename LlrMetrics::Type(-llrMetrics_.max())};
-  typename LlrMetrics::Type metric[2] = {
-    typename LlrMetrics::Type(0),
-    typename LlrMetrics::Type(0)};
+  const size_t inputSize = shape_.inputSize();
+  const size_t bitCount = inputSize + (hasParity ? shape_.outputSize() : 0);
+  auto max = bitMetric + 2*bitCount;
+  std::fill(max, max + 2*bitCount, -llrMetrics_.max());
+  std::fill(bitMetric, bitMetric + 2*bitCount, typename LlrMetrics::Type(0));
+  
   auto branchMetricTmp = branchMetric;
-  for (size_t k = 0; k < structure().trellis().stateCount(); ++k) {
-    for (BitField<size_t> input = 0; input < structure().trellis().inputCount(); ++input) {
-      max[input.test(j)] = logSum_.max(branchMetric[input], max[input.test(j)]);
+  auto state = structure().trellis().beginState();
+  auto output = structure().trellis().beginOutput();
+  for (size_t k = 0; k < shape_.stateCount(); ++k) {
+    for (BitField<size_t> input = 0; input < shape_.inputCount(); ++input) {
+      branchMetric[input] = logSum_.prior(branchMetric[input] + forwardMetric[k] + backwardMetric[size_t(state[input])]);
+      for (size_t j = 0; j < inputSize; ++j) {
+        size_t idx = 2*j + input.test(j);
+        max[idx] = logSum_.max(branchMetric[input], max[idx]);
+      }
+      for (size_t j = inputSize; j < bitCount; ++j) {
+        size_t idx = 2*j + output[input].test(j-inputSize);
+        max[idx] = logSum_.max(branchMetric[input], max[idx]);
+      }
     }
-    branchMetric += structure().trellis().inputCount();
+    branchMetric += shape_.inputCount();
+    state += shape_.inputCount();
+    output += shape_.inputCount();
   }
   branchMetric = branchMetricTmp;
-  for (size_t k = 0; k < structure().trellis().stateCount(); ++k) {
-    for (BitField<size_t> input = 0; input < structure().trellis().inputCount(); ++input) {
-      metric[input.test(j)] = logSum_.sum(logSum_.prior(branchMetric[input], max[input.test(j)]), metric[input.test(j)]);
-    }
-    branchMetric += structure().trellis().inputCount();
-  }
-  return logSum_.post(metric[1], max[1]) - logSum_.post(metric[0], max[0]);
-}
-
-template <class LlrMetrics, template <class> class LogSumAlg>
-template <class U, typename std::enable_if<!U::value>::type*>
-typename LlrMetrics::Type MapDecoderImpl<LlrMetrics, LogSumAlg>::parityUpdateImpl(typename std::vector<typename LlrMetrics::Type>::iterator branchMetric, size_t j)
-{
-  typename LlrMetrics::Type max[2] = {typename LlrMetrics::Type(-llrMetrics_.max()), typename LlrMetrics::Type(-llrMetrics_.max())};
-  typename LlrMetrics::Type metric[2] = {
-    typename LlrMetrics::Type(0),
-    typename LlrMetrics::Type(0)};
-  auto branchMetricTmp = branchMetric;
-  for (auto output = structure().trellis().beginOutput(); output < structure().trellis().endOutput();) {
-    for (BitField<size_t> input = 0; input < structure().trellis().inputCount(); ++input) {
-      max[output[input].test(j)] = logSum_.max(branchMetric[input], max[output[input].test(j)]);
+  output = structure().trellis().beginOutput();
+  for (size_t k = 0; k < shape_.stateCount(); ++k) {
+    for (BitField<size_t> input = 0; input < shape_.inputCount(); ++input) {
+      for (size_t j = 0; j < inputSize; ++j) {
+        size_t idx = 2*j + input.test(j);
+        bitMetric[idx] = logSum_.sum(logSum_.prior(branchMetric[input], max[idx]), bitMetric[idx]);
+      }
+      for (size_t j = inputSize; j < bitCount; ++j) {
+        size_t idx = 2*j + output[input].test(j-inputSize);
+        bitMetric[idx] = logSum_.sum(logSum_.prior(branchMetric[input], max[idx]), bitMetric[idx]);
+      }
     }
-    branchMetric += structure().trellis().inputCount();
-    output += structure().trellis().inputCount();
+    branchMetric += shape_.inputCount();
+    output += shape_.inputCount();
   }
-  branchMetric = branchMetricTmp;
-  for (auto output = structure().trellis().beginOutput(); output < structure().trellis().endOutput();) {
-    for (BitField<size_t> input = 0; input < structure().trellis().inputCount(); ++input) {
-      metric[output[input].test(j)] = logSum_.sum(logSum_.prior(branchMetric[input], max[output[input].test(j)]), metric[output[input].test(j)]);
-    }
-    branchMetric += structure().trellis().inputCount();
-    output += structure().trellis().inputCount();
+  for (size_t j = 0; j < bitCount; ++j) {
+    bitMetric[j] = logSum_.post(bitMetric[2*j+1], max[2*j+1]) - logSum_.post(bitMetric[2*j], max[2*j]);
   }
-  return logSum_.post(metric[1], max[1]) - logSum_.post(metric[0], max[0]);
 }
 
 //Explicit instantiation
-template class fec::detail::MapDecoderImpl<FloatLlrMetrics, LogSum>;
-template class fec::detail::MapDecoderImpl<FloatLlrMetrics, MaxLogSum>;
-template class fec::detail::MapDecoderImpl<FloatLlrMetrics, LinearLogSum>;
+template class fec::detail::MapDecoderImpl<FloatLlrMetrics, LogSum, DynamicTrellisShape>;
+template class fec::detail::MapDecoderImpl<FloatLlrMetrics, MaxLogSum, DynamicTrellisShape>;
+template class fec::detail::MapDecoderImpl<FloatLlrMetrics, LinearLogSum, DynamicTrellisShape>;
+template class fec::detail::MapDecoderImpl<FloatLlrMetrics, LogSum, FixedTrellisShape<8, 1, 1>>;
+template class fec::detail::MapDecoderImpl<FloatLlrMetrics, MaxLogSum, FixedTrellisShape<8, 1, 1>>;
+template class fec::detail::MapDecoderImpl<FloatLlrMetrics, LinearLogSum, FixedTrellisShape<8, 1, 1>>;
+template class fec::detail::MapDecoderImpl<FloatLlrMetrics, LogSum, FixedTrellisShape<8, 1, 2>>;
+template class fec::detail::MapDecoderImpl<FloatLlrMetrics, MaxLogSum, FixedTrellisShape<8, 1, 2>>;
+template class fec::detail::MapDecoderImpl<FloatLlrMetrics, LinearLogSum, FixedTrellisShape<8, 1, 2>>;
+template class fec::detail::MapDecoderImpl<FloatLlrMetrics, LogSum, FixedTrellisShape<64, 1, 2>>;
+template class fec::detail::MapDecoderImpl<FloatLlrMetrics, MaxLogSum, FixedTrellisShape<64, 1, 2>>;
+template class fec::detail::MapDecoderImpl<FloatLlrMetrics, LinearLogSum, FixedTrellisShape<64, 1, 2>>;
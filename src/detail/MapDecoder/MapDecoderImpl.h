@@ -26,6 +26,8 @@
 #include <memory>
 
 #include "MapDecoder.h"
+#include "../Arena.h"
+#include "../TrellisShape.h"
 
 namespace fec {
   
@@ -38,8 +40,10 @@ namespace fec {
      *  The reason for this class is to offer an common interface of map decoders
      *  while allowing the compiler to inline implementation specific functions
      *  by using templates instead of polymorphism.
+     *  The dimensions of the trellis are given by Shape,
+     *  which makes them constant for the shapes decoders are specialized for.
      */
-    template <class LlrMetrics, template <class> class LogSumAlg>
+    template <class LlrMetrics, template <class> class LogSumAlg, class Shape = DynamicTrellisShape>
     class MapDecoderImpl : public MapDecoder
     {
     public:
@@ -52,35 +56,43 @@ namespace fec {
     protected:
       template <class T> void branchUpdate(Codec::InfoIterator<typename std::vector<T>::const_iterator> input);/**< Branch metric calculation. */
       void forwardUpdate();/**< Forward metric calculation. */
-      void backwardUpdate();/**< Backard metric calculation. */
-      template <class T> void aPosterioriUpdate(Codec::InfoIterator<typename std::vector<T>::const_iterator> input, Codec::InfoIterator<typename std::vector<T>::iterator> output);/**< Final (msg) L-values calculation. */
+      template <class T> void backwardUpdate(Codec::InfoIterator<typename std::vector<T>::const_iterator> input, Codec::InfoIterator<typename std::vector<T>::iterator> output);/**< Backward metric calculation fused with final L-values calculation. */
+      template <class T> void aPosterioriUpdate(Codec::InfoIterator<typename std::vector<T>::const_iterator> input, Codec::InfoIterator<typename std::vector<T>::iterator> output, size_t first, size_t last);/**< Final (msg) L-values calculation. */
+      template <class T> void aPosterioriStep(Codec::InfoIterator<typename std::vector<T>::const_iterator> input, Codec::InfoIterator<typename std::vector<T>::iterator> output, size_t i, typename AlignedVector<typename LlrMetrics::Type>::iterator branchMetric, typename AlignedVector<typename LlrMetrics::Type>::const_iterator forwardMetric, typename AlignedVector<typename LlrMetrics::Type>::const_iterator backwardMetric, typename AlignedVector<typename LlrMetrics::Type>::iterator bitMetric);/**< Final L-values calculation of one step. */
+      
+      template <class T> void windowDecode(Codec::InfoIterator<typename std::vector<T>::const_iterator> input, Codec::InfoIterator<typename std::vector<T>::iterator> output);/**< Interleaved decoding of all windows. */
       
     private:
       template <class U = typename LogSumAlg<LlrMetrics>::isRecursive, typename std::enable_if<U::value>::type* = nullptr>
-      void forwardUpdateImpl(typename std::vector<typename LlrMetrics::Type>::iterator forwardMetric, typename std::vector<typename LlrMetrics::Type>::const_iterator branchMetric);/**< Forward metric calculation. */
+      void forwardUpdateImpl(typename AlignedVector<typename LlrMetrics::Type>::iterator forwardMetric, typename AlignedVector<typename LlrMetrics::Type>::const_iterator branchMetric, typename AlignedVector<typename LlrMetrics::Type>::iterator bufferMetric);/**< Forward metric calculation. */
       template <class U = typename LogSumAlg<LlrMetrics>::isRecursive, typename std::enable_if<!U::value>::type* = nullptr>
-      void forwardUpdateImpl(typename std::vector<typename LlrMetrics::Type>::iterator forwardMetric, typename std::vector<typename LlrMetrics::Type>::const_iterator branchMetric);/**< Forward metric calculation. */
+      void forwardUpdateImpl(typename AlignedVector<typename LlrMetrics::Type>::iterator forwardMetric, typename AlignedVector<typename LlrMetrics::Type>::const_iterator branchMetric, typename AlignedVector<typename LlrMetrics::Type>::iterator bufferMetric);/**< Forward metric calculation. */
       
       template <class U = typename LogSumAlg<LlrMetrics>::isRecursive, typename std::enable_if<U::value>::type* = nullptr>
-      void backwardUpdateImpl(typename std::vector<typename LlrMetrics::Type>::iterator backwardMetric, typename std::vector<typename LlrMetrics::Type>::const_iterator branchMetric);/**< Forward metric calculation. */
+      void backwardUpdateImpl(typename AlignedVector<typename LlrMetrics::Type>::iterator backwardMetric, typename AlignedVector<typename LlrMetrics::Type>::const_iterator branchMetric, typename AlignedVector<typename LlrMetrics::Type>::iterator bufferMetric);/**< Forward metric calculation. */
       template <class U = typename LogSumAlg<LlrMetrics>::isRecursive, typename std::enable_if<!U::value>::type* = nullptr>
-      void backwardUpdateImpl(typename std::vector<typename LlrMetrics::Type>::iterator backwardMetric, typename std::vector<typename LlrMetrics::Type>::const_iterator branchMetric);/**< Forward metric calculation. */
+      void backwardUpdateImpl(typename AlignedVector<typename LlrMetrics::Type>::iterator backwardMetric, typename AlignedVector<typename LlrMetrics::Type>::const_iterator branchMetric, typename AlignedVector<typename LlrMetrics::Type>::iterator bufferMetric);/**< Forward metric calculation. */
       
       template <class U = typename LogSumAlg<LlrMetrics>::isRecursive, typename std::enable_if<U::value>::type* = nullptr>
-      typename LlrMetrics::Type msgUpdateImpl(typename std::vector<typename LlrMetrics::Type>::iterator branchMetric, size_t j);/**< Forward metric calculation. */
+      void aPosterioriImpl(typename AlignedVector<typename LlrMetrics::Type>::iterator branchMetric, typename AlignedVector<typename LlrMetrics::Type>::const_iterator forwardMetric, typename AlignedVector<typename LlrMetrics::Type>::const_iterator backwardMetric, typename AlignedVector<typename LlrMetrics::Type>::iterator bitMetric, bool hasParity);/**< Input and output bit L-values calculation. */
       template <class U = typename LogSumAlg<LlrMetrics>::isRecursive, typename std::enable_if<!U::value>::type* = nullptr>
-      typename LlrMetrics::Type msgUpdateImpl(typename std::vector<typename LlrMetrics::Type>::iterator branchMetric, size_t j);/**< Forward metric calculation. */
+      void aPosterioriImpl(typename AlignedVector<typename LlrMetrics::Type>::iterator branchMetric, typename AlignedVector<typename LlrMetrics::Type>::const_iterator forwardMetric, typename AlignedVector<typename LlrMetrics::Type>::const_iterator backwardMetric, typename AlignedVector<typename LlrMetrics::Type>::iterator bitMetric, bool hasParity);/**< Input and output bit L-values calculation. */
       
-      template <class U = typename LogSumAlg<LlrMetrics>::isRecursive, typename std::enable_if<U::value>::type* = nullptr>
-      typename LlrMetrics::Type parityUpdateImpl(typename std::vector<typename LlrMetrics::Type>::iterator branchMetric, size_t j);/**< Forward metric calculation. */
-      template <class U = typename LogSumAlg<LlrMetrics>::isRecursive, typename std::enable_if<!U::value>::type* = nullptr>
-      typename LlrMetrics::Type parityUpdateImpl(typename std::vector<typename LlrMetrics::Type>::iterator branchMetric, size_t j);/**< Forward metric calculation. */
+      void normalize(typename AlignedVector<typename LlrMetrics::Type>::iterator metric);/**< Metric normalization after each step. */
+      
+      size_t stepCount() const {return structure().length() + structure().tailSize();}
+      size_t windowSize() const {return (stepCount() + structure().windowCount() - 1) / structure().windowCount();}
+      size_t guardSize() const {return 8 * (structure().trellis().stateSize() + 1);}/**< Number of steps used to estimate metrics at window boundaries. */
+      
+      Shape shape_;/**< Dimensions of the trellis */
       
-      std::vector<typename LlrMetrics::Type> bufferMetrics_;
+      AlignedVector<typename LlrMetrics::Type> bufferMetrics_;
+      AlignedVector<typename LlrMetrics::Type> windowMetrics_;/**< Boundary metric buffer for each window */
+      AlignedVector<typename LlrMetrics::Type> bitMetrics_;/**< Bit metric accumulators */
       
-      std::vector<typename LlrMetrics::Type> branchMetrics_;/**< Branch metric buffer (gamma) */
-      std::vector<typename LlrMetrics::Type> forwardMetrics_;/**< Forward metric buffer (alpha) */
-      std::vector<typename LlrMetrics::Type> backwardMetrics_;/**< Backard metric buffer (beta) */
+      AlignedVector<typename LlrMetrics::Type> branchMetrics_;/**< Branch metric buffer (gamma) */
+      AlignedVector<typename LlrMetrics::Type> forwardMetrics_;/**< Forward metric buffer (alpha) */
+      AlignedVector<typename LlrMetrics::Type> backwardMetrics_;/**< Backard metric buffer (beta), only two steps when decoding in a single window */
       
       LlrMetrics llrMetrics_;
       LogSumAlg<LlrMetrics> logSum_;
@@ -0,0 +1,180 @@
+/*******************************************************************************
+ This file is part of FeCl.
+ 
+ Copyright (c) 2015, Etienne Pierre-Doray, INRS
+ Copyright (c) 2015, Leszek Szczecinski, INRS
+ All rights reserved.
+ 
+ FeCl is free software: you can redistribute it and/or modify
+ it under the terms of the Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ FeCl is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the Lesser General Public License
+ along with FeCl.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+#include "Numa.h"
+
+using namespace fec::detail::Numa;
+
+namespace {
+  
+  /**
+   *  Parses a list of ranges such as "0-3,8,10-11".
+   */
+  std::vector<size_t> parseList(const std::string& list)
+  {
+    std::vector<size_t> values;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+      size_t first, last;
+      char dash;
+      std::stringstream rangeStream(range);
+      if (!(rangeStream >> first)) {
+        continue;
+      }
+      last = first;
+      if (rangeStream >> dash >> last) {
+        if (dash != '-' || last < first) {
+          continue;
+        }
+      }
+      for (size_t i = first; i <= last; ++i) {
+        values.push_back(i);
+      }
+    }
+    return values;
+  }
+  
+  std::string readLine(const std::string& path)
+  {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+  }
+
+}
+
+#if defined(__linux__)
+struct ThreadBinding::Affinity {
+  cpu_set_t cpus;
+};
+#else
+struct ThreadBinding::Affinity {};
+#endif
+
+/**
+ *  Access the topology of the machine.
+ */
+const Topology& Topology::get()
+{
+#if defined(__linux__)
+  static const Topology topology("/sys/devices/system/node");
+#else
+  static const Topology topology("");
+#endif
+  return topology;
+}
+
+/**
+ *  Reads the nodes and their cpus from sysfs.
+ *  Nodes without cpus are skipped since no thread can run on them,
+ *  such that nodes are indexed from 0 to nodeCount()-1 independently of their id.
+ *  \param  root Directory describing the nodes, such as /sys/devices/system/node
+ */
+Topology::Topology(const std::string& root)
+{
+  if (!root.empty()) {
+    for (auto node : parseList(readLine(root + "/online"))) {
+      auto cpus = parseList(readLine(root + "/node" + std::to_string(node) + "/cpulist"));
+      if (!cpus.empty()) {
+        ids_.push_back(node);
+        cpus_.push_back(cpus);
+      }
+    }
+  }
+  if (cpus_.empty()) {
+    ids_.assign(1, 0);
+    cpus_.resize(1);
+  }
+}
+
+/**
+ *  Finds the node holding the page of an address.
+ *  The page needs to be touched beforehand.
+ *  \param  address Address in the page
+ *  \return Node index, or 0 when it cannot be found or the node has no cpus
+ */
+size_t Topology::nodeOf(const void* address) const
+{
+#if defined(__linux__) && defined(SYS_get_mempolicy)
+  if (nodeCount() > 1) {
+    const int flags = 3; // MPOL_F_NODE | MPOL_F_ADDR
+    int node = -1;
+    if (syscall(SYS_get_mempolicy, &node, nullptr, 0, const_cast<void*>(address), flags) == 0 && node >= 0) {
+      for (size_t i = 0; i < nodeCount(); ++i) {
+        if (ids_[i] == size_t(node)) {
+          return i;
+        }
+      }
+    }
+  }
+#endif
+  return 0;
+}
+
+/**
+ *  Binds the calling thread to the cpus of a node.
+ *  Nothing is done if the machine has a single node or if the affinity cannot be set.
+ *  \param  node Node index
+ */
+ThreadBinding::ThreadBinding(size_t node)
+{
+#if defined(__linux__)
+  const auto& topology = Topology::get();
+  if (topology.nodeCount() <= 1 || node >= topology.nodeCount()) {
+    return;
+  }
+  std::unique_ptr<Affinity> previous(new Affinity);
+  if (sched_getaffinity(0, sizeof(cpu_set_t), &previous->cpus) != 0) {
+    return;
+  }
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  for (auto cpu : topology.cpus(node)) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &cpus);
+    }
+  }
+  if (sched_setaffinity(0, sizeof(cpu_set_t), &cpus) == 0) {
+    previous_ = std::move(previous);
+  }
+#endif
+}
+
+ThreadBinding::~ThreadBinding()
+{
+#if defined(__linux__)
+  if (previous_) {
+    sched_setaffinity(0, sizeof(cpu_set_t), &previous_->cpus);
+  }
+#endif
+}
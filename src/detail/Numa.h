@@ -0,0 +1,83 @@
+/*******************************************************************************
+ This file is part of FeCl.
+ 
+ Copyright (c) 2015, Etienne Pierre-Doray, INRS
+ Copyright (c) 2015, Leszek Szczecinski, INRS
+ All rights reserved.
+ 
+ FeCl is free software: you can redistribute it and/or modify
+ it under the terms of the Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ FeCl is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the Lesser General Public License
+ along with FeCl.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#ifndef FEC_DETAIL_NUMA_H
+#define FEC_DETAIL_NUMA_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fec {
+  
+  namespace detail {
+    
+    namespace Numa {
+      
+      /**
+       *  This class describes the NUMA nodes of the machine and the cpus they hold.
+       *  The topology is read once from the operating system.
+       *  Where it is not available, the machine is seen as a single node.
+       */
+      class Topology {
+      public:
+        static const Topology& get();
+        
+        Topology(const std::string& root);
+        
+        size_t nodeCount() const {return cpus_.size();} /**< Access the number of nodes. */
+        size_t id(size_t node) const {return ids_[node];} /**< Access the operating system id of a node. */
+        const std::vector<size_t>& cpus(size_t node) const {return cpus_[node];} /**< Access the cpus of a node. */
+        
+        size_t nodeOf(const void* address) const;
+      
+      private:
+        std::vector<size_t> ids_;
+        std::vector<std::vector<size_t>> cpus_;
+      };
+      
+      /**
+       *  Restricts the calling thread to the cpus of a node for its lifetime.
+       *  The previous affinity of the thread is restored on destruction.
+       */
+      class ThreadBinding {
+      public:
+        ThreadBinding(size_t node);
+        ~ThreadBinding();
+        
+        ThreadBinding(const ThreadBinding&) = delete;
+        ThreadBinding& operator=(const ThreadBinding&) = delete;
+        
+        bool isBound() const {return previous_ != nullptr;} /**< Access wether the thread was bound. */
+      
+      private:
+        struct Affinity;
+        std::unique_ptr<Affinity> previous_;
+      };
+    
+    }
+  
+  }
+
+}
+
+#endif
@@ -0,0 +1,97 @@
+/*******************************************************************************
+ This file is part of FeCl.
+ 
+ Copyright (c) 2015, Etienne Pierre-Doray, INRS
+ Copyright (c) 2015, Leszek Szczecinski, INRS
+ All rights reserved.
+ 
+ FeCl is free software: you can redistribute it and/or modify
+ it under the terms of the Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ FeCl is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the Lesser General Public License
+ along with FeCl.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#ifndef FEC_DETAIL_TRELLIS_SHAPE_H
+#define FEC_DETAIL_TRELLIS_SHAPE_H
+
+#include <cstddef>
+
+#include "../Trellis.h"
+
+namespace fec {
+  
+  namespace detail {
+    
+    /**
+     *  This class gives the dimensions of a trellis known at compile time.
+     *  Kernels templated on it see constant loop bounds,
+     *  which the compiler can unroll.
+     *  The state and output tables are still read from the trellis.
+     */
+    template <size_t StateCount, size_t InputSize, size_t OutputSize>
+    class FixedTrellisShape {
+    public:
+      FixedTrellisShape(const Trellis&) {}
+      
+      static bool matches(const Trellis& trellis) {return trellis.stateCount() == StateCount && trellis.inputSize() == InputSize && trellis.outputSize() == OutputSize;} /**< Access wether a trellis has these dimensions. */
+      
+      size_t stateCount() const {return StateCount;}
+      size_t inputSize() const {return InputSize;}
+      size_t inputCount() const {return size_t(1) << InputSize;}
+      size_t outputSize() const {return OutputSize;}
+      size_t outputCount() const {return size_t(1) << OutputSize;}
+      size_t tableSize() const {return StateCount << InputSize;}
+    };
+    
+    /**
+     *  This class gives the dimensions of any trellis, read once at construction.
+     *  It is the fallback of kernels when no fixed shape matches.
+     */
+    class DynamicTrellisShape {
+    public:
+      DynamicTrellisShape(const Trellis& trellis) :
+      stateCount_(trellis.stateCount()), inputSize_(trellis.inputSize()), outputSize_(trellis.outputSize()) {}
+      
+      static bool matches(const Trellis&) {return true;}
+      
+      size_t stateCount() const {return stateCount_;}
+      size_t inputSize() const {return inputSize_;}
+      size_t inputCount() const {return size_t(1) << inputSize_;}
+      size_t outputSize() const {return outputSize_;}
+      size_t outputCount() const {return size_t(1) << outputSize_;}
+      size_t tableSize() const {return stateCount_ << inputSize_;}
+    
+    private:
+      size_t stateCount_;
+      size_t inputSize_;
+      size_t outputSize_;
+    };
+    
+    template <class... Shapes>
+    struct TrellisShapeList {};
+    
+    /**
+     *  Shapes for which decoders are specialized, tried in order.
+     *  They cover the LTE turbo constituent (8 states, one parity bit),
+     *  memory-3 rate 1/2 codes such as (017, 015)
+     *  and memory-6 rate 1/2 codes such as the CCSDS and 802.11 code (0171, 0133).
+     */
+    typedef TrellisShapeList<
+      FixedTrellisShape<8, 1, 1>,
+      FixedTrellisShape<8, 1, 2>,
+      FixedTrellisShape<64, 1, 2>
+    > StandardTrellisShapes;
+  
+  }
+
+}
+
+#endif
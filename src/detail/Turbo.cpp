@@ -61,11 +61,7 @@ void Turbo::Structure::setEncoderOptions(const Turbo::EncoderOptions &encoder)
   constituents_.clear();
   for (size_t i = 0; i < interleaver_.size(); ++i) {
     if (interleaver_[i].outputSize() == 0) {
-      std::vector<size_t> tmp(msgSize());
-      for (size_t j = 0; j < tmp.size(); ++j) {
-        tmp[j] = j;
-      }
-      interleaver_[i] = tmp;
+      interleaver_[i] = Permutation::identity(msgSize());
     }
     size_t j = i;
     if (encoder.trellis_.size() == 1) {
@@ -125,6 +121,8 @@ void Turbo::Structure::setDecoderOptions(const Turbo::DecoderOptions &decoder)
   }
   decoderAlgorithm_ = decoder.algorithm_;
   scalingFactor_ = decoder.scalingFactor_;
+  windowCount_ = decoder.windowCount_;
+  radix_ = decoder.radix_;
   if (scalingFactor_.size() == constituentCount()) {
     for (size_t i = 0; i < scalingFactor_.size(); ++i) {
       if (scalingFactor_[i].size() != iterations() && scalingFactor_[i].size() != 1) {
@@ -135,14 +133,14 @@ void Turbo::Structure::setDecoderOptions(const Turbo::DecoderOptions &decoder)
     throw std::invalid_argument("Wrong size for scaling factor");
   }
   for (size_t i = 0; i < interleaver_.size(); ++i) {
-    auto constituentOptions = Convolutional::DecoderOptions().algorithm(decoder.algorithm_).scalingFactor(1.0);
+    auto constituentOptions = Convolutional::DecoderOptions().algorithm(decoder.algorithm_).scalingFactor(1.0).windowCount(decoder.windowCount_).radix(decoder.radix_);
     constituents_[i].setDecoderOptions(constituentOptions);
   }
 }
 
 Turbo::DecoderOptions Turbo::Structure::getDecoderOptions() const
 {
-  return DecoderOptions().iterations(iterations()).scheduling(scheduling()).scheduling(schedulingType()).algorithm(decoderAlgorithm()).scalingFactor(scalingFactor_);
+  return DecoderOptions().iterations(iterations()).scheduling(scheduling()).scheduling(schedulingType()).algorithm(decoderAlgorithm()).scalingFactor(scalingFactor_).windowCount(windowCount()).radix(radix());
 }
 
 double Turbo::Structure::scalingFactor(size_t i, size_t j) const
@@ -154,18 +152,37 @@ double Turbo::Structure::scalingFactor(size_t i, size_t j) const
 
 void Turbo::Structure::encode(std::vector<BitField<size_t>>::const_iterator msg, std::vector<BitField<size_t>>::iterator parity) const
 {
-  std::vector<BitField<size_t>> messageInterl;
-  std::vector<BitField<size_t>>::iterator parityOutIt;
-  parityOutIt = parity;
-  std::copy(msg, msg + msgSize(), parityOutIt);
-  auto systTail = parityOutIt + msgSize();
-  parityOutIt += systSize();
+  encode(msg, parity, 1);
+}
+
+/**
+ *  Encodes several blocks of msg bits.
+ *  The interleaved msg buffer is allocated once for all blocks.
+ *  \param  msg  Input iterator pointing to the first element in the msg bit sequence.
+ *  \param  parity[out] Output iterator pointing to the first element in the parity bit sequence.
+ *  \param  n Number of blocks
+ */
+void Turbo::Structure::encode(std::vector<BitField<size_t>>::const_iterator msg, std::vector<BitField<size_t>>::iterator parity, size_t n) const
+{
+  size_t bufferSize = 0;
   for (size_t i = 0; i < constituentCount(); ++i) {
-    messageInterl.resize(constituent(i).msgSize());
-    interleaver(i).permuteBlock<BitField<size_t>>(msg, messageInterl.begin());
-    constituent(i).encode(messageInterl.begin(), parityOutIt, systTail);
-    systTail += constituent(i).systTailSize();
-    parityOutIt += constituent(i).paritySize();
+    bufferSize = std::max(bufferSize, constituent(i).msgSize());
+  }
+  std::vector<BitField<size_t>> messageInterl(bufferSize);
+  for (size_t j = 0; j < n; ++j) {
+    std::vector<BitField<size_t>>::iterator parityOutIt;
+    parityOutIt = parity;
+    std::copy(msg, msg + msgSize(), parityOutIt);
+    auto systTail = parityOutIt + msgSize();
+    parityOutIt += systSize();
+    for (size_t i = 0; i < constituentCount(); ++i) {
+      interleaver(i).permuteBlock<BitField<size_t>>(msg, messageInterl.begin());
+      constituent(i).encode(messageInterl.begin(), parityOutIt, systTail);
+      systTail += constituent(i).systTailSize();
+      parityOutIt += constituent(i).paritySize();
+    }
+    msg += msgSize();
+    parity += paritySize();
   }
 }
 
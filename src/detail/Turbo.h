@@ -23,6 +23,7 @@
 #define FEC_DETAIL_TURBO_H
 
 #include <boost/serialization/export.hpp>
+#include <boost/serialization/version.hpp>
 
 #include "Codec.h"
 #include "Convolutional.h"
@@ -85,12 +86,16 @@ namespace fec {
         DecoderOptions& algorithm(DecoderAlgorithm algorithm) {algorithm_ = algorithm; return *this;}
         DecoderOptions& scalingFactor(double factor) {scalingFactor_ = {{factor}}; return *this;}
         DecoderOptions& scalingFactor(const std::vector<std::vector<double>>& factor) {scalingFactor_ = factor; return *this;}
+        DecoderOptions& windowCount(size_t count) {windowCount_ = count; return *this;}
+        DecoderOptions& radix(size_t radix) {radix_ = radix; return *this;}
         
         size_t iterations() const {return iterations_;}
         SchedulingType schedulingType() const {return schedulingType_;}
         Scheduling scheduling() const {return scheduling_;}
         DecoderAlgorithm algorithm() const {return algorithm_;}
         std::vector<std::vector<double>> scalingFactor() const {return scalingFactor_;}
+        size_t windowCount() const {return windowCount_;}
+        size_t radix() const {return radix_;}
         
       private:
         size_t iterations_ = 6;
@@ -98,6 +103,8 @@ namespace fec {
         Scheduling scheduling_;
         DecoderAlgorithm algorithm_ = Linear;
         std::vector<std::vector<double>> scalingFactor_ = {{1.0}};
+        size_t windowCount_ = 1;
+        size_t radix_ = 2;
       };
       
       struct PunctureOptions {
@@ -128,6 +135,7 @@ namespace fec {
         virtual ~Structure() = default;
         
         virtual const char * get_key() const;
+        virtual Structure* clone() const {return new Structure(*this);} /**< Creates a copy of the structure. */
         
         void setDecoderOptions(const DecoderOptions& decoder);
         DecoderOptions getDecoderOptions() const;
@@ -147,11 +155,14 @@ namespace fec {
         inline size_t iterations() const {return iterations_;}
         inline SchedulingType schedulingType() const {return schedulingType_;}
         inline const Scheduling& scheduling() const {return scheduling_;}
+        inline size_t windowCount() const {return windowCount_;} /**< Access the number of independent windows in each constituent. */
+        inline size_t radix() const {return radix_;} /**< Access the radix of the constituent trellis used in decoders. */
         
         double scalingFactor(size_t i, size_t j) const; /**< Access the scalingFactor value used in decoder. */
         
         virtual bool check(std::vector<BitField<size_t>>::const_iterator parity) const;
         virtual void encode(std::vector<BitField<size_t>>::const_iterator msg, std::vector<BitField<size_t>>::iterator parity) const;
+        void encode(std::vector<BitField<size_t>>::const_iterator msg, std::vector<BitField<size_t>>::iterator parity, size_t n) const;
         
         Permutation puncturing(const PunctureOptions& options) const;
         
@@ -169,6 +180,8 @@ namespace fec {
         SchedulingType schedulingType_;
         Scheduling scheduling_;
         std::vector<std::vector<double>> scalingFactor_;
+        size_t windowCount_ = 1;
+        size_t radix_ = 2;
       };
       
     }
@@ -178,6 +191,7 @@ namespace fec {
 
 
 BOOST_CLASS_EXPORT_KEY(fec::detail::Turbo::Structure);
+BOOST_CLASS_VERSION(fec::detail::Turbo::Structure, 1);
 BOOST_CLASS_TYPE_INFO(fec::detail::Turbo::Structure,extended_type_info_no_rtti<fec::detail::Turbo::Structure>);
 
 
@@ -192,6 +206,10 @@ void fec::detail::Turbo::Structure::serialize(Archive & ar, const unsigned int v
   ar & ::BOOST_SERIALIZATION_NVP(schedulingType_);
   ar & ::BOOST_SERIALIZATION_NVP(scheduling_);
   ar & ::BOOST_SERIALIZATION_NVP(scalingFactor_);
+  if (version >= 1) {
+    ar & ::BOOST_SERIALIZATION_NVP(windowCount_);
+    ar & ::BOOST_SERIALIZATION_NVP(radix_);
+  }
 }
 
 #endif
@@ -40,6 +40,7 @@ namespace fec {
       virtual ~TurboDecoder() = default;
       
       void decodeBlocks(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, size_t n);
+      void decodeBlocks(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, std::vector<BitField<size_t>>::iterator converged, size_t n, Codec::Deadline& deadline);
       void soDecodeBlocks(Codec::InputIterator input, Codec::OutputIterator output, size_t n);
       
     protected:
@@ -48,7 +49,7 @@ namespace fec {
       
       inline const Turbo::Structure& structure() const {return structure_;}
       
-      virtual void decodeBlock(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg) = 0;
+      virtual bool decodeBlock(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, Codec::Deadline::Clock::time_point deadline) = 0;
       virtual void soDecodeBlock(Codec::InputIterator input, Codec::OutputIterator output) = 0;
       
       std::vector<std::unique_ptr<MapDecoder>> code_;
@@ -26,13 +26,68 @@ using namespace fec::detail;
 
 TurboDecoderImpl::TurboDecoderImpl(const Turbo::Structure& structure) : TurboDecoder(structure)
 {
+  const size_t count = this->structure().constituentCount();
+  extrinsicOffsets_.resize(count);
+  std::vector<std::vector<uint32_t>> deinterleaverOffsets(count);
+  std::vector<std::vector<uint32_t>> deinterleaver(count);
+  size_t offset = 0;
+  for (size_t j = 0; j < count; ++j) {
+    extrinsicOffsets_[j] = offset;
+    offset += this->structure().constituent(j).systSize();
+    
+    auto& offsets = deinterleaverOffsets[j];
+    offsets.assign(this->structure().msgSize()+1, 0);
+    this->structure().interleaver(j).forEach([&](size_t, size_t idx) {++offsets[idx+1];});
+    for (size_t idx = 0; idx < this->structure().msgSize(); ++idx) {
+      offsets[idx+1] += offsets[idx];
+    }
+    deinterleaver[j].resize(offsets.back());
+    std::vector<uint32_t> position(offsets.begin(), offsets.end()-1);
+    this->structure().interleaver(j).forEach([&](size_t k, size_t idx) {deinterleaver[j][position[idx]++] = uint32_t(k);});
+  }
+  
+  composedOffsets_.resize(count*count);
+  composed_.resize(count*count);
+  for (size_t i = 0; i < count; ++i) {
+    for (size_t j = 0; j < count; ++j) {
+      if (j == i) {
+        continue;
+      }
+      auto& offsets = composedOffsets_[i*count+j];
+      auto& composed = composed_[i*count+j];
+      bool isOneToOne = true;
+      offsets.push_back(0);
+      this->structure().interleaver(i).forEach([&](size_t, size_t idx) {
+        isOneToOne &= (deinterleaverOffsets[j][idx+1] - deinterleaverOffsets[j][idx] == 1);
+        composed.insert(composed.end(), deinterleaver[j].begin() + deinterleaverOffsets[j][idx], deinterleaver[j].begin() + deinterleaverOffsets[j][idx+1]);
+        offsets.push_back(uint32_t(composed.size()));
+      });
+      if (isOneToOne) {
+        offsets.clear();
+      }
+    }
+  }
+  sources_.reserve(this->structure().constituentCount());
+  hardMsg_.resize(this->structure().msgSize());
 }
 
-void TurboDecoderImpl::decodeBlock(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg)
+/**
+ *  Decodes one bloc of information bits.
+ *  When a deadline is given, iterations stop once it is passed,
+ *  or when the hard decisions on the msg are unchanged by an iteration.
+ *  Without deadline, every iteration is run.
+ *  \return  True if the hard decisions were detected as stable
+ */
+bool TurboDecoderImpl::decodeBlock(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, Codec::Deadline::Clock::time_point deadline)
 {
+  const bool isTimed = (deadline != Codec::Deadline::Clock::time_point::max());
+  bool converged = false;
   std::copy(parity, parity + structure().paritySize(), parityIn_.begin());
   std::fill(extrinsic_.begin(), extrinsic_.end(), 0);
   for (size_t i = 0; i < structure().iterations(); ++i) {
+    if (Codec::Deadline::isExpired(deadline)) {
+      break;
+    }
     if (structure().schedulingType() == Parallel) {
       parallelTransferUpdate();
     }
@@ -62,6 +117,21 @@ void TurboDecoderImpl::decodeBlock(std::vector<double>::const_iterator parity, s
         parityIt += structure().constituent(j).paritySize();
       }
     }
+    
+    if (isTimed) {
+      std::copy(parityIn_.begin(), parityIn_.begin()+structure().msgSize(), parityOut_.begin());
+      aPosterioriUpdate();
+      bool isStable = (i > 0);
+      for (size_t k = 0; k < structure().msgSize(); ++k) {
+        BitField<size_t> bit = parityOut_[k] > 0;
+        isStable = isStable && (bit == hardMsg_[k]);
+        hardMsg_[k] = bit;
+      }
+      if (isStable) {
+        converged = true;
+        break;
+      }
+    }
   }
   std::copy(parityIn_.begin(), parityIn_.begin()+structure().msgSize(), parityOut_.begin());
   aPosterioriUpdate();
@@ -69,6 +139,7 @@ void TurboDecoderImpl::decodeBlock(std::vector<double>::const_iterator parity, s
   for (size_t i = 0; i < structure().msgSize(); ++i) {
     msg[i] = parityOut_[i] > 0;
   }
+  return converged;
 }
 
 
@@ -155,9 +226,7 @@ void TurboDecoderImpl::aPosterioriUpdate()
   auto systTail = parityOut_.begin() + structure().msgSize();
   auto syst = parityOut_.begin();
   for (size_t j = 0; j < structure().constituentCount(); ++j) {
-    for (size_t k = 0; k < structure().constituent(j).msgSize(); ++k) {
-      syst[structure().interleaver(j)[k]] += extrinsic[k];
-    }
+    structure().interleaver(j).forEach([&](size_t k, size_t idx) {syst[idx] += extrinsic[k];});
     extrinsic += structure().constituent(j).msgSize();
     for (size_t k = 0; k < structure().constituent(j).systTailSize(); ++k) {
       systTail[k] += extrinsic[k];
@@ -197,11 +266,11 @@ void TurboDecoderImpl::parallelTransferUpdate()
   auto syst = parityOut_.begin();
   std::fill(parityOut_.begin(), parityOut_.begin() + structure().msgSize(), 0);
   for (size_t j = 0; j < structure().constituentCount(); ++j) {
-    for (size_t k = 0; k < structure().constituent(j).msgSize(); ++k) {
+    structure().interleaver(j).forEach([&](size_t k, size_t idx) {
       extrinsicTmp[k] = extrinsic[k];
-      extrinsic[k] = syst[structure().interleaver(j)[k]];
-      syst[structure().interleaver(j)[k]] += extrinsicTmp[k];
-    }
+      extrinsic[k] = syst[idx];
+      syst[idx] += extrinsicTmp[k];
+    });
     extrinsic += structure().constituent(j).msgSize();
     extrinsicTmp += structure().constituent(j).msgSize();
     
@@ -215,76 +284,81 @@ void TurboDecoderImpl::parallelTransferUpdate()
   for (int64_t j = structure().constituentCount()-1; j >= 0; --j) {
     extrinsic -= structure().constituent(j).systSize();
     extrinsicTmp -= structure().constituent(j).msgSize();
-    for (size_t k = 0; k < structure().constituent(j).msgSize(); ++k) {
-      extrinsic[k] += syst[structure().interleaver(j)[k]];
-      syst[structure().interleaver(j)[k]] += extrinsicTmp[k];
-    }
+    structure().interleaver(j).forEach([&](size_t k, size_t idx) {
+      extrinsic[k] += syst[idx];
+      syst[idx] += extrinsicTmp[k];
+    });
   }
 }
 
 void TurboDecoderImpl::serialTransferUpdate(size_t i)
 {
-  auto extrinsic = extrinsic_.begin();
   auto systTail = parityIn_.begin() + structure().msgSize();
-  auto syst = parityOut_.begin();
-  std::copy(parityIn_.begin(), parityIn_.begin() + structure().msgSize(), parityOut_.begin());
   for (size_t j = 0; j < i; ++j) {
-    for (size_t k = 0; k < structure().constituent(j).msgSize(); ++k) {
-      syst[structure().interleaver(j)[k]] += extrinsic[k];
-    }
-    extrinsic += structure().constituent(j).systSize();
     systTail += structure().constituent(j).systTailSize();
   }
-  auto extrinsicTmp = extrinsic;
-  extrinsic += structure().constituent(i).msgSize();
-  std::copy(systTail, systTail + structure().constituent(i).systTailSize(), extrinsic);
-  extrinsic += structure().constituent(i).systTailSize();
-  for (size_t j = i+1; j < structure().constituentCount(); ++j) {
-    for (size_t k = 0; k < structure().constituent(j).msgSize(); ++k) {
-      syst[structure().interleaver(j)[k]] += extrinsic[k];
+  auto extrinsic = extrinsic_.begin() + extrinsicOffsets_[i];
+  std::copy(systTail, systTail + structure().constituent(i).systTailSize(), extrinsic + structure().constituent(i).msgSize());
+  
+  sources_.clear();
+  for (size_t j = 0; j < structure().constituentCount(); ++j) {
+    if (j != i) {
+      sources_.push_back(j);
     }
-    extrinsic += structure().constituent(j).systSize();
   }
-  
-  structure().interleaver(i).template permuteBlock<double>(syst, extrinsicTmp);
+  gatherTransferUpdate(i, extrinsic_.begin(), extrinsic);
 }
 
 void TurboDecoderImpl::customTransferUpdate(size_t stage, size_t src)
 {
   size_t i = structure().scheduling()[stage].activation[src];
-  auto extrinsic = extrinsic_.begin();
-  auto extrinsicTmp = extrinsicBuffer_.begin();
   auto systTail = parityIn_.begin() + structure().msgSize();
-  auto syst = parityOut_.begin();
-  auto transfer = structure().scheduling()[stage].transfer[src].begin();
-  std::copy(parityIn_.begin(), parityIn_.begin() + structure().msgSize(), parityOut_.begin());
   for (size_t j = 0; j < i; ++j) {
-    while (transfer != structure().scheduling()[stage].transfer[src].end() && *transfer < j) {++transfer;}
-    if (transfer != structure().scheduling()[stage].transfer[src].end() && *transfer == j) {
-      for (size_t k = 0; k < structure().constituent(j).msgSize(); ++k) {
-        syst[structure().interleaver(j)[k]] += extrinsic[k];
-      }
-    }
-    extrinsic += structure().constituent(j).systSize();
-    extrinsicTmp += structure().constituent(j).systSize();
     systTail += structure().constituent(j).systTailSize();
   }
-  auto extrinsicConst = extrinsicTmp;
-  extrinsic += structure().constituent(i).msgSize();
-  std::copy(systTail, systTail + structure().constituent(i).systTailSize(), extrinsic);
-  extrinsic += structure().constituent(i).systTailSize();
-  for (size_t j = i+1; j < structure().constituentCount(); ++j) {
-    while (transfer != structure().scheduling()[stage].transfer[src].end() && *transfer < j) {++transfer;}
-    if (transfer != structure().scheduling()[stage].transfer[src].end() && *transfer == j) {
-      for (size_t k = 0; k < structure().constituent(j).msgSize(); ++k) {
-        syst[structure().interleaver(j)[k]] += extrinsic[k];
-      }
-    } else if (transfer == structure().scheduling()[stage].transfer[src].end()) {
-      break;
+  auto extrinsic = extrinsic_.begin() + extrinsicOffsets_[i];
+  std::copy(systTail, systTail + structure().constituent(i).systTailSize(), extrinsic + structure().constituent(i).msgSize());
+  
+  sources_.clear();
+  for (auto transfer : structure().scheduling()[stage].transfer[src]) {
+    if (transfer != i && transfer < structure().constituentCount()) {
+      sources_.push_back(transfer);
     }
-    extrinsic += structure().constituent(j).systSize();
   }
-  
-  structure().interleaver(i).template permuteBlock<double>(syst, extrinsicConst);
+  sources_.erase(std::unique(sources_.begin(), sources_.end()), sources_.end());
+  gatherTransferUpdate(i, extrinsic_.begin(), extrinsicBuffer_.begin() + extrinsicOffsets_[i]);
 }
 
+/**
+ *  Computes the a-priori msg information of a constituent directly in its interleaved order.
+ *  Each element starts from the channel information of its msg bit.
+ *  The extrinsic information of every source constituent is then added
+ *  through the composed permutation from the destination to the source interleaved order,
+ *  instead of accumulating all contributions in msg order and interleaving the sum.
+ *  Contributions are added in the same order as the accumulation.
+ *  \param  i Destination constituent
+ *  \param  extrinsic Extrinsic information of every constituent
+ *  \param  apriori[out] A-priori msg information of the destination constituent
+ */
+void TurboDecoderImpl::gatherTransferUpdate(size_t i, std::vector<double>::const_iterator extrinsic, std::vector<double>::iterator apriori)
+{
+  structure().interleaver(i).permuteBlock<double>(parityIn_.begin(), apriori);
+  const size_t size = structure().constituent(i).msgSize();
+  for (auto j : sources_) {
+    auto source = extrinsic + extrinsicOffsets_[j];
+    const auto& composed = composed_[i*structure().constituentCount()+j];
+    const auto& offsets = composedOffsets_[i*structure().constituentCount()+j];
+    if (offsets.empty()) {
+      for (size_t k = 0; k < size; ++k) {
+        apriori[k] += source[composed[k]];
+      }
+    }
+    else {
+      for (size_t k = 0; k < size; ++k) {
+        for (uint32_t l = offsets[k]; l < offsets[k+1]; ++l) {
+          apriori[k] += source[composed[l]];
+        }
+      }
+    }
+  }
+}
@@ -42,7 +42,7 @@ namespace fec {
     protected:
       TurboDecoderImpl() = default;
       
-      virtual void decodeBlock(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg);
+      virtual bool decodeBlock(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, Codec::Deadline::Clock::time_point deadline);
       virtual void soDecodeBlock(Codec::InputIterator input, Codec::OutputIterator output);
       
     private:
@@ -53,6 +53,13 @@ namespace fec {
       void serialTransferUpdate(size_t i);
       void parallelTransferUpdate();
       void customTransferUpdate(size_t stage, size_t i);
+      void gatherTransferUpdate(size_t i, std::vector<double>::const_iterator extrinsic, std::vector<double>::iterator apriori);
+      
+      std::vector<size_t> extrinsicOffsets_;/**< Offset of each constituent in the extrinsic buffer */
+      std::vector<std::vector<uint32_t>> composedOffsets_;/**< For each destination and source constituent pair, offset of each destination element in composed_, empty when there is exactly one per element */
+      std::vector<std::vector<uint32_t>> composed_;/**< For each destination and source constituent pair, source interleaved indices reading the msg bit of each destination element */
+      std::vector<size_t> sources_;/**< Constituents contributing to the current transfer */
+      std::vector<BitField<size_t>> hardMsg_;/**< Hard decisions on the msg after the last iteration */
     };
     
   }
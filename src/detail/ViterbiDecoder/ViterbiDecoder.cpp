@@ -25,16 +25,39 @@
 using namespace fec;
 using namespace fec::detail;
 
+namespace {
+  
+  std::unique_ptr<ViterbiDecoder> createImpl(const Convolutional::Structure& structure, TrellisShapeList<>)
+  {
+    return std::unique_ptr<ViterbiDecoder>(new ViterbiDecoderImpl<FloatLlrMetrics, DynamicTrellisShape>(structure));
+  }
+  
+  /**
+   *  Creates the decoder specialized for the first shape matching the trellis,
+   *  or the generic decoder if none does.
+   */
+  template <class Shape, class... Shapes>
+  std::unique_ptr<ViterbiDecoder> createImpl(const Convolutional::Structure& structure, TrellisShapeList<Shape, Shapes...>)
+  {
+    if (Shape::matches(structure.trellis())) {
+      return std::unique_ptr<ViterbiDecoder>(new ViterbiDecoderImpl<FloatLlrMetrics, Shape>(structure));
+    }
+    return createImpl(structure, TrellisShapeList<Shapes...>());
+  }
+
+}
+
 /**
  *  MapDecoder creator function.
  *  Construct in a factory behavior a MapCodec object corresponding to the algorithm
  *  version in use.
  *  \param  codeStructure Convolutional code structure describing the code
+ *  Trellises with one of the StandardTrellisShapes get a decoder specialized for it.
  *  \return MacDecoder specialization suitable for the algorithm in use
  */
 std::unique_ptr<ViterbiDecoder> ViterbiDecoder::create(const Convolutional::Structure& structure)
 {
-  return std::unique_ptr<ViterbiDecoder>(new ViterbiDecoderImpl<FloatLlrMetrics>(structure));
+  return createImpl(structure.decoderStructure(), StandardTrellisShapes());
 }
 
 /**
@@ -44,8 +67,8 @@ void ViterbiDecoder::decodeBlocks(std::vector<double>::const_iterator parity, st
 {
   for (size_t i = 0; i < n; i++) {
     decodeBlock(parity, msg);
-    parity += structure().trellis().outputSize() * (structure().length() + structure().tailSize());
-    msg += structure().trellis().inputSize() * structure().length();
+    parity += structure().paritySize();
+    msg += structure().msgSize();
   }
 }
 
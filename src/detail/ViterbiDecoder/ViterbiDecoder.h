@@ -39,7 +39,7 @@ namespace fec {
     {
     public:
       static std::unique_ptr<ViterbiDecoder> create(const Convolutional::Structure&); /**< Creating function */
-      ~ViterbiDecoder() = default;
+      virtual ~ViterbiDecoder() = default;
       
       void decodeBlocks(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg, size_t n);
       virtual void decodeBlock(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg) = 0;
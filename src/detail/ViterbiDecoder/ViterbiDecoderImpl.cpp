@@ -32,41 +32,78 @@ using namespace fec::detail;
  *    in the decoded msg sequence.
  *    Output needs to be pre-allocated.
  */
-template <class LlrMetrics>
-void ViterbiDecoderImpl<LlrMetrics>::decodeBlock(std::vector<double>::const_iterator parityIn, std::vector<BitField<size_t>>::iterator messageOut)
+template <class LlrMetrics, class Shape>
+void ViterbiDecoderImpl<LlrMetrics, Shape>::decodeBlock(std::vector<double>::const_iterator parityIn, std::vector<BitField<size_t>>::iterator messageOut)
 {
   previousPathMetrics_[0] = 0;
   std::fill(previousPathMetrics_.begin()+1, previousPathMetrics_.end(), -llrMetrics_.max());
   auto stateTraceBack = stateTraceBack_.begin();
   auto inputTraceBack = inputTraceBack_.begin();
   
+  const size_t stateCount = shape_.stateCount();
+  const size_t inputCount = shape_.inputCount();
   for (size_t i = 0; i < structure().length() + structure().tailSize(); ++i) {
-    std::fill(nextPathMetrics_.begin(), nextPathMetrics_.end(), -llrMetrics_.max());
+    size_t parityCount = std::min(shape_.outputSize(), structure().paritySize() - i * shape_.outputSize());
+    size_t systCount = std::min(shape_.inputSize(), structure().systSize() - i * shape_.inputSize());
+    correlations<LlrMetrics>(parityIn, parityCount, shape_.outputSize(), branchMetrics_.begin());
+    parityIn += shape_.outputSize();
     
-    for (BitField<size_t> j = 0; j < structure().trellis().outputCount(); ++j) {
-      branchMetrics_[j] = correlation<LlrMetrics>(j, parityIn, structure().trellis().outputSize());
+    auto previousInput = structure().trellis().beginPreviousInput();
+    auto previousOutput = structure().trellis().beginPreviousOutput();
+    if (structure().trellis().isButterfly() && systCount == shape_.inputSize()) {
+      for (size_t j = 0; j < stateCount/2; ++j) {
+        typename LlrMetrics::Type metric[2] = {previousPathMetrics_[2*j], previousPathMetrics_[2*j+1]};
+        for (size_t k = 0; k < 2; ++k) {
+          size_t state = j + k*stateCount/2;
+          typename LlrMetrics::Type competitor[2] = {
+            metric[0] + branchMetrics_[previousOutput[2*state]],
+            metric[1] + branchMetrics_[previousOutput[2*state+1]]
+          };
+          size_t best = (competitor[1] >= competitor[0]);
+          nextPathMetrics_[state] = competitor[best];
+          stateTraceBack[state] = 2*j + best;
+          inputTraceBack[state] = previousInput[2*state + best];
+        }
+      }
     }
-    parityIn += structure().trellis().outputSize();
-  
-    auto previousPathMetricsIt = previousPathMetrics_.begin();
-    auto state = structure().trellis().beginState();
-    auto output = structure().trellis().beginOutput();
-    for (BitField<size_t> j = 0; j < structure().trellis().stateCount(); ++j) {
-      for (BitField<size_t> k = 0; k < structure().trellis().inputCount(); ++k) {
-        auto & pathMetricRef = nextPathMetrics_[state[k]];
-        typename LlrMetrics::Type competitor = *previousPathMetricsIt + branchMetrics_[output[k]];
-        if (competitor >= pathMetricRef) {
-          stateTraceBack[state[k]] = j;
-          inputTraceBack[state[k]] = k;
-          pathMetricRef = competitor;
+    else if (!structure().trellis().hasPredecessors()) {
+      std::fill(nextPathMetrics_.begin(), nextPathMetrics_.end(), -llrMetrics_.max());
+      auto state = structure().trellis().beginState();
+      auto output = structure().trellis().beginOutput();
+      for (size_t j = 0; j < stateCount; ++j) {
+        for (size_t k = 0; k < inputCount; ++k) {
+          auto & pathMetricRef = nextPathMetrics_[state[k]];
+          typename LlrMetrics::Type competitor = previousPathMetrics_[j] + branchMetrics_[output[k]];
+          if (competitor >= pathMetricRef && (k >> systCount) == 0) {
+            stateTraceBack[state[k]] = j;
+            inputTraceBack[state[k]] = k;
+            pathMetricRef = competitor;
+          }
         }
+        state += inputCount;
+        output += inputCount;
       }
-      state+=structure().trellis().inputCount();
-      output+=structure().trellis().inputCount();
-      previousPathMetricsIt++;
     }
-    stateTraceBack += structure().trellis().stateCount();
-    inputTraceBack += structure().trellis().stateCount();
+    else {
+      auto previousState = structure().trellis().beginPreviousState();
+      for (size_t j = 0; j < stateCount; ++j) {
+        typename LlrMetrics::Type pathMetric = -llrMetrics_.max();
+        for (size_t k = 0; k < inputCount; ++k) {
+          typename LlrMetrics::Type competitor = previousPathMetrics_[previousState[k]] + branchMetrics_[previousOutput[k]];
+          if (competitor >= pathMetric && (previousInput[k] >> systCount) == 0) {
+            stateTraceBack[j] = previousState[k];
+            inputTraceBack[j] = previousInput[k];
+            pathMetric = competitor;
+          }
+        }
+        nextPathMetrics_[j] = pathMetric;
+        previousState += inputCount;
+        previousInput += inputCount;
+        previousOutput += inputCount;
+      }
+    }
+    stateTraceBack += shape_.stateCount();
+    inputTraceBack += shape_.stateCount();
     
     typename LlrMetrics::Type max = -llrMetrics_.max();
     for (auto nextPathMetric = nextPathMetrics_.begin(); nextPathMetric < nextPathMetrics_.end(); nextPathMetric++) {
@@ -80,13 +117,13 @@ void ViterbiDecoderImpl<LlrMetrics>::decodeBlock(std::vector<double>::const_iter
     swap(previousPathMetrics_, nextPathMetrics_);
   }
   
-  stateTraceBack -= structure().trellis().stateCount();
-  inputTraceBack -= structure().trellis().stateCount();
+  stateTraceBack -= shape_.stateCount();
+  inputTraceBack -= shape_.stateCount();
   
   BitField<size_t> bestState = 0;
   switch (structure().termination()) {
     case Trellis::Truncate:
-      for (BitField<size_t> i = 0; i < structure().trellis().stateCount(); ++i) {
+      for (BitField<size_t> i = 0; i < shape_.stateCount(); ++i) {
         if (previousPathMetrics_[i] > previousPathMetrics_[bestState]) {
           bestState = i;
         }
@@ -98,17 +135,14 @@ void ViterbiDecoderImpl<LlrMetrics>::decodeBlock(std::vector<double>::const_iter
       break;
   }
   
-  messageOut += (structure().length() - 1) * structure().trellis().inputSize();
-  for (int64_t i = structure().length() + structure().tailSize() - 1; i >= 0; --i) {
-    if (i < structure().length()) {
-      for (BitField<size_t> j = 0; j < structure().trellis().inputSize(); ++j) {
-        messageOut[j] = inputTraceBack[bestState].test(j);
-      }
-      messageOut -= structure().trellis().inputSize();
+  for (size_t i = structure().length() + structure().tailSize(); i > 0; --i) {
+    size_t offset = (i-1) * shape_.inputSize();
+    for (size_t j = 0; offset + j < structure().msgSize() && j < shape_.inputSize(); ++j) {
+      messageOut[offset + j] = inputTraceBack[bestState].test(j);
     }
     bestState = stateTraceBack[bestState];
-    stateTraceBack -= structure().trellis().stateCount();
-    inputTraceBack -= structure().trellis().stateCount();
+    stateTraceBack -= shape_.stateCount();
+    inputTraceBack -= shape_.stateCount();
   }
 }
 
@@ -117,9 +151,9 @@ void ViterbiDecoderImpl<LlrMetrics>::decodeBlock(std::vector<double>::const_iter
  *  Allocates metric buffers based on the given code structure.
  *  \param  codeStructure Convolutional code structure describing the code
  */
-template <class LlrMetrics>
-ViterbiDecoderImpl<LlrMetrics>::ViterbiDecoderImpl(const Convolutional::Structure& structure) :
-ViterbiDecoder(structure)
+template <class LlrMetrics, class Shape>
+ViterbiDecoderImpl<LlrMetrics, Shape>::ViterbiDecoderImpl(const Convolutional::Structure& structure) :
+ViterbiDecoder(structure), shape_(structure.trellis())
 {
   nextPathMetrics_.resize(structure.trellis().stateCount());
   previousPathMetrics_.resize(structure.trellis().stateCount());
@@ -128,4 +162,7 @@ ViterbiDecoder(structure)
   branchMetrics_.resize(structure.trellis().outputCount());
 }
 
-template class fec::detail::ViterbiDecoderImpl<FloatLlrMetrics>;
+template class fec::detail::ViterbiDecoderImpl<FloatLlrMetrics, DynamicTrellisShape>;
+template class fec::detail::ViterbiDecoderImpl<FloatLlrMetrics, FixedTrellisShape<8, 1, 1>>;
+template class fec::detail::ViterbiDecoderImpl<FloatLlrMetrics, FixedTrellisShape<8, 1, 2>>;
+template class fec::detail::ViterbiDecoderImpl<FloatLlrMetrics, FixedTrellisShape<64, 1, 2>>;
@@ -26,6 +26,8 @@
 #include <memory>
 
 #include "ViterbiDecoder.h"
+#include "../Arena.h"
+#include "../TrellisShape.h"
 
 namespace fec {
   
@@ -34,8 +36,9 @@ namespace fec {
     /**
      *  This class contains the implementation of the viterbi decoder.
      *  This algorithm is used for simple decoding in a ConvolutionalCodec.
+     *  The dimensions of the trellis are given by Shape.
      */
-    template <class LlrMetrics>
+    template <class LlrMetrics, class Shape = DynamicTrellisShape>
     class ViterbiDecoderImpl : public ViterbiDecoder
     {
     public:
@@ -45,13 +48,14 @@ namespace fec {
       virtual void decodeBlock(std::vector<double>::const_iterator parity, std::vector<BitField<size_t>>::iterator msg);
       
     protected:
-      std::vector<typename LlrMetrics::Type> previousPathMetrics_;
-      std::vector<typename LlrMetrics::Type> nextPathMetrics_;
-      std::vector<typename LlrMetrics::Type> branchMetrics_;
+      AlignedVector<typename LlrMetrics::Type> previousPathMetrics_;
+      AlignedVector<typename LlrMetrics::Type> nextPathMetrics_;
+      AlignedVector<typename LlrMetrics::Type> branchMetrics_;
       std::vector<BitField<uint16_t>> stateTraceBack_;
       std::vector<BitField<uint16_t>> inputTraceBack_;
       
     private:
+      Shape shape_;/**< Dimensions of the trellis */
       FloatLlrMetrics llrMetrics_;
     };
     
@@ -23,11 +23,13 @@
 #include <random>
 #include <memory>
 #include <functional>
+#include <cmath>
 
 #include <boost/test/included/unit_test.hpp>
 using namespace boost::unit_test;
 
 #include "operations.h"
+#include "detail/FastMath.h"
 
 void test_convo_soDecode_systOut(const fec::Codec& code, size_t n = 1)
 {
@@ -48,6 +50,124 @@ void test_convo_soDecode_systOut(const fec::Codec& code, size_t n = 1)
   }
 }
 
+void test_convo_puncturing(fec::Convolutional code, const std::vector<bool>& mask)
+{
+  auto perm = code.puncturing(fec::Convolutional::PunctureOptions().mask(mask));
+  BOOST_REQUIRE(perm.type() == fec::Permutation::Periodic);
+  
+  std::vector<size_t> sequence;
+  for (size_t i = 0; i < code.paritySize(); ++i) {
+    if (mask[i % mask.size()]) {
+      sequence.push_back(i);
+    }
+  }
+  BOOST_REQUIRE(perm.inputSize() == code.paritySize());
+  BOOST_REQUIRE(perm.outputSize() == sequence.size());
+  std::vector<size_t> index(code.paritySize());
+  for (size_t i = 0; i < index.size(); ++i) {
+    index[i] = i;
+  }
+  auto permuted = perm.permute(index);
+  for (size_t i = 0; i < sequence.size(); ++i) {
+    BOOST_REQUIRE(perm[i] == sequence[i]);
+    BOOST_REQUIRE(permuted[i] == sequence[i]);
+  }
+}
+
+void test_convo_radix4(const fec::Convolutional::EncoderOptions& encoder, fec::Convolutional::DecoderOptions decoder, double snr, double tolerance, size_t n = 1)
+{
+  auto radix2 = fec::Convolutional(encoder, decoder.radix(2));
+  auto radix4 = fec::Convolutional(encoder, decoder.radix(4));
+  
+  std::minstd_rand0 randomGenerator;
+  std::vector<fec::BitField<size_t>> msg(radix2.msgSize()*n);
+  for (size_t i = 0; i < msg.size(); ++i) {
+    msg[i] = randomGenerator() % 2;
+  }
+  std::vector<double> parityIn = distort(radix2.encode(msg), snr);
+  
+  std::vector<double> msgOut[2];
+  std::vector<double> systOut[2];
+  std::vector<double> parityOut[2];
+  radix2.soDecode(fec::Codec::Input<>().parity(parityIn), fec::Codec::Output<>().msg(msgOut[0]).syst(systOut[0]).parity(parityOut[0]));
+  radix4.soDecode(fec::Codec::Input<>().parity(parityIn), fec::Codec::Output<>().msg(msgOut[1]).syst(systOut[1]).parity(parityOut[1]));
+  auto close = [tolerance](const std::vector<double>& a, const std::vector<double>& b) {
+    BOOST_REQUIRE(a.size() == b.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+      BOOST_REQUIRE(std::abs(a[i] - b[i]) <= tolerance * (1.0 + std::abs(a[i])));
+    }
+  };
+  close(msgOut[0], msgOut[1]);
+  close(systOut[0], systOut[1]);
+  close(parityOut[0], parityOut[1]);
+  
+  BOOST_REQUIRE(radix2.decode(parityIn) == radix4.decode(parityIn));
+}
+
+void test_trellis_predecessors(const fec::Trellis& trellis, bool butterfly)
+{
+  BOOST_REQUIRE(trellis.isButterfly() == butterfly);
+  auto previousState = trellis.beginPreviousState();
+  auto previousInput = trellis.beginPreviousInput();
+  auto previousOutput = trellis.beginPreviousOutput();
+  for (size_t i = 0; i < trellis.stateCount(); ++i) {
+    for (size_t k = 0; k < trellis.inputCount(); ++k) {
+      BOOST_REQUIRE(trellis.getNextState(previousState[k], previousInput[k]) == i);
+      BOOST_REQUIRE(trellis.getOutput(previousState[k], previousInput[k]) == previousOutput[k]);
+    }
+    previousState += trellis.inputCount();
+    previousInput += trellis.inputCount();
+    previousOutput += trellis.inputCount();
+  }
+}
+
+void test_trellis_noPredecessors(const fec::Trellis& trellis)
+{
+  BOOST_REQUIRE(!trellis.hasPredecessors());
+  BOOST_REQUIRE(!trellis.isButterfly());
+}
+
+void test_fastMath()
+{
+  const double bound = 4e-14;
+  auto relativeError = [](double x, double ref) {return std::abs(x - ref) / std::abs(ref);};
+  
+  for (double x = -708.0; x <= 709.0; x += 1.0/256.0) {
+    BOOST_REQUIRE(relativeError(fec::detail::fastExp(x), std::exp(x)) < bound);
+  }
+  BOOST_REQUIRE(fec::detail::fastExp(-800.0) == 0.0);
+  BOOST_REQUIRE(fec::detail::fastExp(800.0) == std::numeric_limits<double>::infinity());
+  
+  for (int k = -1021; k <= 1024; ++k) {
+    for (double m = 0.5; m < 1.0; m += 1.0/1024.0) {
+      double x = std::ldexp(m, k);
+      double ref = std::log(x);
+      if (ref == 0.0) {
+        BOOST_REQUIRE(fec::detail::fastLog(x) == 0.0);
+      }
+      else {
+        BOOST_REQUIRE(relativeError(fec::detail::fastLog(x), ref) < bound);
+      }
+    }
+  }
+  BOOST_REQUIRE(relativeError(fec::detail::fastLog(std::sqrt(0.5)), std::log(std::sqrt(0.5))) < bound);
+  BOOST_REQUIRE(relativeError(fec::detail::fastLog(std::sqrt(2.0)), std::log(std::sqrt(2.0))) < bound);
+  BOOST_REQUIRE(fec::detail::fastLog(0.0) == -std::numeric_limits<double>::infinity());
+  BOOST_REQUIRE(fec::detail::fastLog(std::numeric_limits<double>::infinity()) == std::numeric_limits<double>::infinity());
+  
+  for (double x = -40.0; x <= 40.0; x += 1.0/1024.0) {
+    if (x != 0.0) {
+      BOOST_REQUIRE(relativeError(fec::detail::fastTanh(x), std::tanh(x)) < bound);
+    }
+  }
+  for (int k = 4; k < 1000; ++k) {
+    double x = std::ldexp(1.0 + 1.0/3.0, -k);
+    BOOST_REQUIRE(relativeError(fec::detail::fastTanh(x), std::tanh(x)) < bound);
+    BOOST_REQUIRE(relativeError(fec::detail::fastTanh(-x), std::tanh(-x)) < bound);
+  }
+  BOOST_REQUIRE(fec::detail::fastTanh(0.0) == 0.0);
+}
+
 test_suite* test_convolutional(const fec::Convolutional::EncoderOptions& encoder, const fec::Convolutional::DecoderOptions& decoder, const fec::Convolutional::PunctureOptions& puncture, double snr, const std::string& name)
 {
   test_suite* ts = BOOST_TEST_SUITE(name);
@@ -63,6 +183,8 @@ test_suite* test_convolutional(const fec::Convolutional::EncoderOptions& encoder
   
   ts->add( BOOST_TEST_CASE(std::bind( &test_decode, codec, snr, 1) ));
   ts->add( BOOST_TEST_CASE(std::bind( &test_decode, codec, snr, 5) ));
+  ts->add( BOOST_TEST_CASE(std::bind( &test_fileDecoder, codec, snr, 5) ));
+  ts->add( BOOST_TEST_CASE(std::bind( &test_decode_memoryPool<fec::Convolutional>, codec, snr, 5) ));
   ts->add( BOOST_TEST_CASE(std::bind( &test_decode_badParitySize, codec )));
   
   ts->add( BOOST_TEST_CASE(std::bind( &test_soDecode, codec, snr, 1) ));
@@ -93,6 +215,17 @@ test_suite* init_unit_test_suite( int argc, char* argv[] )
   auto puncture = fec::Convolutional::PunctureOptions().mask({1, 0, 0, 1});
   
   framework::master_test_suite().add(test_convolutional(encoder, decoder, puncture, 3.0, "default"));
+  framework::master_test_suite().add(BOOST_TEST_CASE(std::bind(&test_convo_puncturing, fec::Convolutional(encoder, decoder), std::vector<bool>{1, 0, 0, 1})));
+  framework::master_test_suite().add(BOOST_TEST_CASE(std::bind(&test_trellis_predecessors, trellis, true)));
+  framework::master_test_suite().add(BOOST_TEST_CASE(std::bind(&test_trellis_predecessors, trellis.collapse(), false)));
+  framework::master_test_suite().add(BOOST_TEST_CASE(&test_fastMath));
+  
+  fec::Trellis irregular({0, 0, 1, 0}, {0, 1, 3, 2}, 1, 2, 1);
+  framework::master_test_suite().add(BOOST_TEST_CASE(std::bind(&test_trellis_noPredecessors, irregular)));
+  framework::master_test_suite().add(BOOST_TEST_CASE(std::bind(&test_trellis_noPredecessors, fec::Trellis({18}, {{0400003}}))));
+  framework::master_test_suite().add(test_convolutional(fec::Convolutional::EncoderOptions(irregular, length), decoder, {}, 8.0, "irregular"));
+  framework::master_test_suite().add(test_convolutional(fec::Convolutional::EncoderOptions(irregular, length), fec::Convolutional::DecoderOptions().algorithm(fec::Approximate), {}, 8.0, "irregular + approximate"));
+  framework::master_test_suite().add(test_convolutional(fec::Convolutional::EncoderOptions(irregular, length), fec::Convolutional::DecoderOptions(decoder).radix(4), {}, 8.0, "irregular + radix 4"));
   
   encoder.termination(fec::Trellis::Tail);
   framework::master_test_suite().add(test_convolutional(encoder, decoder, puncture, 3.0, "tail"));
@@ -109,5 +242,34 @@ test_suite* init_unit_test_suite( int argc, char* argv[] )
   encoder.termination(fec::Trellis::Tail);
   framework::master_test_suite().add(test_convolutional(encoder, decoder, {}, 5.0, "2 inputs + tail"));
   
+  decoder.radix(4);
+  framework::master_test_suite().add(test_convolutional(encoder, decoder, {}, 5.0, "2 inputs + tail + radix 4"));
+  
+  encoder = fec::Convolutional::EncoderOptions(trellis, length).termination(fec::Trellis::Truncate);
+  decoder.algorithm(fec::Exact);
+  framework::master_test_suite().add(test_convolutional(encoder, decoder, puncture, 3.0, "radix 4"));
+  
+  encoder.termination(fec::Trellis::Tail);
+  framework::master_test_suite().add(test_convolutional(encoder, decoder, puncture, 3.0, "radix 4 + tail"));
+  
+  encoder = fec::Convolutional::EncoderOptions(trellis, length-1).termination(fec::Trellis::Truncate);
+  framework::master_test_suite().add(test_convolutional(encoder, decoder, {}, 3.0, "radix 4 + odd length"));
+  
+  for (auto algorithm : {fec::Exact, fec::Linear, fec::Approximate}) {
+    decoder.algorithm(algorithm);
+    double tolerance = (algorithm == fec::Linear) ? 5e-2 : 1e-3;
+    for (auto termination : {fec::Trellis::Truncate, fec::Trellis::Tail}) {
+      for (size_t radixLength : {length, length-1}) {
+        encoder = fec::Convolutional::EncoderOptions(trellis, radixLength).termination(termination);
+        framework::master_test_suite().add(BOOST_TEST_CASE(std::bind(&test_convo_radix4, encoder, decoder, 0.0, tolerance, 3)));
+      }
+    }
+  }
+  decoder.algorithm(fec::Exact);
+  
+  encoder = fec::Convolutional::EncoderOptions(fec::Trellis({7}, {{0171, 0133}}), length).termination(fec::Trellis::Tail);
+  decoder.radix(2);
+  framework::master_test_suite().add(test_convolutional(encoder, decoder, {}, 3.0, "64 states"));
+  
   return 0;
 }
\ No newline at end of file
@@ -48,6 +48,121 @@ void test_ldpc_soDecode_systOut(const fec::Ldpc& code, size_t n = 1)
   }
 }
 
+void test_ldpc_checkEach(const fec::Ldpc& code, size_t n)
+{
+  std::vector<fec::BitField<size_t>> msg(code.msgSize()*n, 1);
+  std::vector<fec::BitField<size_t>> parity;
+  code.encode(msg, parity);
+  parity[3*code.paritySize()] ^= 1;
+  parity[(n-1)*code.paritySize()+code.paritySize()-1] ^= 1;
+  
+  auto result = code.checkEach(parity);
+  auto syndrome = code.syndromes(parity);
+  BOOST_REQUIRE(result.size() == n);
+  BOOST_REQUIRE(syndrome.size() % n == 0);
+  size_t checkCount = syndrome.size() / n;
+  for (size_t i = 0; i < n; ++i) {
+    bool failure = (i == 3 || i == n-1);
+    BOOST_CHECK(result[i] == !failure);
+    BOOST_CHECK(std::any_of(syndrome.begin()+i*checkCount, syndrome.begin()+(i+1)*checkCount, [](fec::BitField<size_t> x) {return x != 0;}) == failure);
+  }
+  BOOST_CHECK(!code.check(parity));
+}
+
+void test_ldpc_generatorMatrix(const fec::Ldpc& code, size_t n)
+{
+  std::vector<fec::BitField<size_t>> msg(code.msgSize()*n);
+  std::minstd_rand0 randomGenerator;
+  fec::BitMatrix msgMatrix(n, code.msgSize());
+  for (size_t i = 0; i < msg.size(); ++i) {
+    msg[i] = randomGenerator() & 1;
+    msgMatrix[i / code.msgSize()].set(i % code.msgSize(), msg[i] != 0);
+  }
+  auto parity = code.encode(msg);
+  
+  auto generator = code.generatorMatrix();
+  auto parityMatrix = msgMatrix * generator;
+  BOOST_REQUIRE(parityMatrix.rows() == n);
+  BOOST_REQUIRE(parityMatrix.cols() == code.paritySize());
+  for (size_t i = 0; i < parity.size(); ++i) {
+    BOOST_REQUIRE(parityMatrix[i / code.paritySize()].test(i % code.paritySize()) == (parity[i] != 0));
+  }
+  
+  auto transpose = generator.transpose();
+  BOOST_REQUIRE(transpose.rows() == generator.cols());
+  BOOST_REQUIRE(transpose.cols() == generator.rows());
+  for (size_t i = 0; i < generator.rows(); ++i) {
+    for (size_t j = 0; j < generator.cols(); ++j) {
+      BOOST_REQUIRE(transpose[j].test(i) == generator[i].test(j));
+    }
+  }
+}
+
+void test_sparseBitMatrix_builder()
+{
+  size_t rows = 20;
+  size_t cols = 30;
+  std::minstd_rand0 randomGenerator;
+  fec::SparseBitMatrix::Builder builder(rows, cols);
+  fec::BitMatrix reference(rows, cols);
+  for (size_t e = 0; e < 100; ++e) {
+    size_t i = randomGenerator() % rows;
+    size_t j = randomGenerator() % cols;
+    builder.set(i, j);
+    reference[i].set(j);
+  }
+  
+  std::vector<size_t> permutation(cols);
+  for (size_t j = 0; j < cols; ++j) {
+    permutation[j] = (j * 7 + 3) % cols;
+  }
+  builder.permuteCols(permutation, {5, 15});
+  fec::BitMatrix permuted(rows, cols);
+  for (size_t i = 0; i < rows; ++i) {
+    for (size_t j = 0; j < cols; ++j) {
+      bool inRange = (i >= 5 && i < 15);
+      permuted[i].set(inRange ? permutation[j] : j, reference[i].test(j));
+    }
+  }
+  builder.set(7, 2);
+  permuted[7].set(2);
+  
+  fec::SparseBitMatrix x;
+  fec::SparseBitMatrix xt;
+  builder.build(x, xt);
+  BOOST_REQUIRE(x.rows() == rows);
+  BOOST_REQUIRE(x.cols() == cols);
+  BOOST_REQUIRE(xt.rows() == cols);
+  BOOST_REQUIRE(xt.cols() == rows);
+  size_t size = 0;
+  for (size_t i = 0; i < rows; ++i) {
+    BOOST_REQUIRE(std::is_sorted(x[i].begin(), x[i].end()));
+    for (size_t j = 0; j < cols; ++j) {
+      BOOST_REQUIRE(x[i].test(j) == permuted[i].test(j));
+      BOOST_REQUIRE(xt[j].test(i) == permuted[i].test(j));
+      size += permuted[i].test(j);
+    }
+  }
+  BOOST_REQUIRE(x.size() == size);
+  BOOST_CHECK_THROW(builder.set(rows, 0), std::invalid_argument);
+  BOOST_CHECK_THROW(builder.permuteCols(std::vector<size_t>(cols-1)), std::invalid_argument);
+}
+
+void test_ldpc_checkGenerator(const fec::SparseBitMatrix& checkMatrix)
+{
+  auto code = fec::Ldpc(fec::Ldpc::EncoderOptions(checkMatrix), fec::Ldpc::DecoderOptions().iterations(1));
+  auto generator = code.generatorMatrix().transpose();
+  BOOST_REQUIRE(generator.rows() == checkMatrix.cols());
+  BOOST_REQUIRE(generator.cols() == code.msgSize());
+  for (size_t i = 0; i < checkMatrix.rows(); ++i) {
+    fec::BitMatrix::Row product(generator.cols());
+    for (auto j : checkMatrix[i]) {
+      product += generator[j];
+    }
+    BOOST_REQUIRE(product.first() == size_t(-1));
+  }
+}
+
 test_suite* test_ldpc(const fec::Ldpc::EncoderOptions& encoder, const fec::Ldpc::DecoderOptions& decoder, const fec::Ldpc::PunctureOptions& puncture, double snr, const std::string& name)
 {
   test_suite* ts = BOOST_TEST_SUITE(name);
@@ -55,16 +170,27 @@ test_suite* test_ldpc(const fec::Ldpc::EncoderOptions& encoder, const fec::Ldpc:
   auto structure = fec::detail::Ldpc::Structure(encoder, decoder);
   
   auto codec = fec::Ldpc(structure);
-
+  
   ts->add( BOOST_TEST_CASE(std::bind(&test_encodeBlock, structure )));
+  ts->add( BOOST_TEST_CASE(std::bind(&test_ldpc_generatorMatrix, codec, 5 )));
   ts->add( BOOST_TEST_CASE(std::bind(&test_encode, codec, 1 )));
   ts->add( BOOST_TEST_CASE(std::bind(&test_encode, codec, 5 )));
   ts->add( BOOST_TEST_CASE(std::bind(&test_encode_badMsgSize, codec )));
+  ts->add( BOOST_TEST_CASE(std::bind(&test_ldpc_checkEach, codec, 70 )));
   
   ts->add( BOOST_TEST_CASE(std::bind( &test_decode, codec, snr, 1) ));
   ts->add( BOOST_TEST_CASE(std::bind( &test_decode, codec, snr, 5) ));
+  ts->add( BOOST_TEST_CASE(std::bind( &test_decode_batchStatistics, codec, snr, 9) ));
+  ts->add( BOOST_TEST_CASE(std::bind( &test_decode_memoryPool<fec::Ldpc>, codec, snr, 5) ));
+  ts->add( BOOST_TEST_CASE(std::bind( &test_decode_numaAware<fec::Ldpc>, codec, snr, 20) ));
+  ts->add( BOOST_TEST_CASE(std::bind( &test_decode_budget, codec, snr, 5) ));
+  ts->add( BOOST_TEST_CASE(std::bind( &test_decode_infiniteBudget, codec, 0.0, 20) ));
+  ts->add( BOOST_TEST_CASE(std::bind( &test_decode_demapper, codec, fec::Demapper::Qam16, fec::Exact, 15.0, 3) ));
+  ts->add( BOOST_TEST_CASE(std::bind( &test_decode_demapper, codec, fec::Demapper::Qam64, fec::Approximate, 21.0, 3) ));
+  ts->add( BOOST_TEST_CASE(std::bind( &test_decode_demapper, codec, fec::Demapper::Qpsk, fec::Linear, 6.0, 3) ));
+  ts->add( BOOST_TEST_CASE(std::bind( &test_demapper_bpsk, fec::Exact) ));
   ts->add( BOOST_TEST_CASE(std::bind( &test_decode_badParitySize, codec )));
-
+  
   ts->add( BOOST_TEST_CASE(std::bind( &test_soDecode, codec, -5.0, 1) ));
   ts->add( BOOST_TEST_CASE(std::bind( &test_soDecode_parityOut, codec, snr, 1) ));
   ts->add( BOOST_TEST_CASE(std::bind( &test_soDecode_0stateIn, codec, 1) ));
@@ -84,6 +210,7 @@ test_suite* test_ldpc(const fec::Ldpc::EncoderOptions& encoder, const fec::Ldpc:
   ts->add( BOOST_TEST_CASE(std::bind(&test_soDecode_noParity, codec )));
   
   ts->add( BOOST_TEST_CASE(std::bind(&test_saveLoad, fec::Ldpc(structure) )));
+  ts->add( BOOST_TEST_CASE(std::bind(&test_saveLoad_decode, fec::Ldpc(structure), 0.0 )));
   
   return ts;
 }
@@ -105,5 +232,17 @@ init_unit_test_suite( int argc, char* argv[] )
   decoder.algorithm(fec::Approximate);
   framework::master_test_suite().add(test_ldpc(encoder,decoder,puncture, 2.0, "approximate"));
   
+  decoder.compactState(true);
+  framework::master_test_suite().add(test_ldpc(encoder,decoder,puncture, 2.0, "approximate + compact state"));
+  decoder.compactState(false);
+  
+  decoder.graphReordering(true);
+  framework::master_test_suite().add(test_ldpc(encoder,decoder,puncture, 2.0, "approximate + reordering"));
+  
+  framework::master_test_suite().add(BOOST_TEST_CASE(&test_sparseBitMatrix_builder));
+  framework::master_test_suite().add(BOOST_TEST_CASE(std::bind(&test_ldpc_checkGenerator, fec::Ldpc::DvbS2::matrix(16200, 3.0/5.0))));
+  framework::master_test_suite().add(BOOST_TEST_CASE(std::bind(&test_ldpc_checkGenerator, fec::Ldpc::DvbS2::matrix(64800, 5.0/6.0))));
+  framework::master_test_suite().add(BOOST_TEST_CASE(&test_numaTopology));
+  
   return 0;
 }
\ No newline at end of file
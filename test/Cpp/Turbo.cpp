@@ -23,11 +23,13 @@
 #include <random>
 #include <memory>
 #include <functional>
+#include <sstream>
 
 #include <boost/test/included/unit_test.hpp>
 using namespace boost::unit_test;
 
 #include "operations.h"
+#include "HarqBuffer.h"
 
 void test_turbo_soDecode_systOut(const fec::Turbo& code, size_t n = 1)
 {
@@ -48,6 +50,99 @@ void test_turbo_soDecode_systOut(const fec::Turbo& code, size_t n = 1)
   }
 }
 
+void test_turbo_lte3gpp_interleaver(size_t length, size_t f1, size_t f2)
+{
+  auto interleaver = fec::Turbo::Lte3Gpp::interleaver(length);
+  BOOST_REQUIRE(interleaver.type() == fec::Permutation::Qpp);
+  BOOST_REQUIRE(interleaver.inputSize() == length);
+  
+  std::vector<size_t> index(length);
+  for (size_t i = 0; i < index.size(); ++i) {
+    index[i] = i;
+  }
+  auto permuted = interleaver.permute(index);
+  auto dePermuted = interleaver.dePermute(permuted);
+  for (size_t i = 0; i < length; ++i) {
+    size_t expected = (f1 * i + f2 * i * i) % length;
+    BOOST_REQUIRE(interleaver[i] == expected);
+    BOOST_REQUIRE(permuted[i] == expected);
+    BOOST_REQUIRE(dePermuted[i] == i);
+  }
+}
+
+/**
+ *  Layout of a Permutation in archives saved before the class was versioned.
+ */
+struct PermutationV0 {
+  std::vector<size_t> sequence_;
+  size_t inputSize_;
+  
+  template <typename Archive>
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & BOOST_SERIALIZATION_NVP(sequence_);
+    ar & BOOST_SERIALIZATION_NVP(inputSize_);
+  }
+};
+
+void test_permutation_loadVersion0(size_t length)
+{
+  PermutationV0 saved;
+  saved.inputSize_ = length + 1;
+  for (size_t i = 0; i < length; ++i) {
+    saved.sequence_.push_back((i * 7 + 3) % saved.inputSize_);
+  }
+  std::stringstream archive;
+  {
+    boost::archive::binary_oarchive oa(archive);
+    oa << saved;
+  }
+  fec::Permutation perm;
+  {
+    boost::archive::binary_iarchive ia(archive);
+    ia >> perm;
+  }
+  
+  BOOST_REQUIRE(perm.type() == fec::Permutation::Table);
+  BOOST_REQUIRE(perm.inputSize() == saved.inputSize_);
+  BOOST_REQUIRE(perm.outputSize() == length);
+  for (size_t i = 0; i < length; ++i) {
+    BOOST_REQUIRE(perm[i] == saved.sequence_[i]);
+  }
+}
+
+void test_turbo_lte3gpp_rateMatching(const fec::Turbo& code)
+{
+  auto rateMatching = fec::Turbo::Lte3Gpp::rateMatching(code, code.paritySize());
+  BOOST_REQUIRE(rateMatching.inputSize() == code.paritySize());
+  BOOST_REQUIRE(rateMatching.outputSize() == code.paritySize());
+  std::vector<size_t> count(code.paritySize(), 0);
+  for (size_t i = 0; i < rateMatching.outputSize(); ++i) {
+    ++count[rateMatching[i]];
+  }
+  for (size_t i = 0; i < count.size(); ++i) {
+    BOOST_REQUIRE(count[i] == 1);
+  }
+  BOOST_REQUIRE(rateMatching[0] == 12);
+}
+
+void test_turbo_lte3gpp_harq(const fec::Turbo& code, double snr, size_t n = 1)
+{
+  std::vector<fec::BitField<size_t>> msg(code.msgSize()*n, 1);
+  std::vector<fec::BitField<size_t>> parity = code.encode(msg);
+  
+  fec::HarqBuffer<int8_t> buffer(parity.size(), 4.0);
+  for (size_t rv = 0; rv < 4; rv += 2) {
+    auto rateMatching = fec::Turbo::Lte3Gpp::rateMatching(code, code.msgSize()*3/2, rv);
+    buffer.combine(distort(rateMatching.permute(parity), snr), rateMatching);
+  }
+  std::vector<fec::BitField<size_t>> msgOut = code.decode(buffer.llr());
+  
+  BOOST_REQUIRE(msgOut.size() == msg.size());
+  for (size_t i = 0; i < msg.size(); ++i) {
+    BOOST_REQUIRE(msg[i] == msgOut[i]);
+  }
+}
+
 test_suite* test_turbo(const fec::Turbo::EncoderOptions& encoder, const fec::Turbo::DecoderOptions& decoder, const fec::Turbo::PunctureOptions& puncture, double snr, const std::string& name)
 {
   test_suite* ts = BOOST_TEST_SUITE(name);
@@ -63,6 +158,8 @@ test_suite* test_turbo(const fec::Turbo::EncoderOptions& encoder, const fec::Tur
   
   ts->add( BOOST_TEST_CASE(std::bind( &test_decode, codec, snr, 1) ));
   ts->add( BOOST_TEST_CASE(std::bind( &test_decode, codec, snr, 5) ));
+  ts->add( BOOST_TEST_CASE(std::bind( &test_decode_budget, codec, snr, 5) ));
+  ts->add( BOOST_TEST_CASE(std::bind( &test_decode_infiniteBudget, codec, -9.0, 50) ));
   ts->add( BOOST_TEST_CASE(std::bind( &test_decode_badParitySize, codec )));
   
   ts->add( BOOST_TEST_CASE(std::bind( &test_soDecode, codec, -5.0, 1) ));
@@ -119,6 +216,20 @@ init_unit_test_suite( int argc, char* argv[] )
   decoder.scheduling(fec::Serial);
   framework::master_test_suite().add(test_turbo(encoder, decoder, puncture, -2.0, "serial"));
   
+  auto windowDecoder = decoder;
+  windowDecoder.windowCount(4);
+  framework::master_test_suite().add(test_turbo(encoder, windowDecoder, puncture, -2.0, "windows"));
+  windowDecoder.algorithm(fec::Exact);
+  framework::master_test_suite().add(test_turbo(encoder, windowDecoder, puncture, -2.0, "windows + exact"));
+  
+  auto radixEncoder = encoder;
+  radixEncoder.termination(fec::Trellis::Truncate);
+  auto radixDecoder = decoder;
+  radixDecoder.radix(4);
+  framework::master_test_suite().add(test_turbo(radixEncoder, radixDecoder, puncture, -2.0, "radix 4"));
+  radixEncoder.termination(fec::Trellis::Tail);
+  framework::master_test_suite().add(test_turbo(radixEncoder, radixDecoder, puncture, -2.0, "radix 4 + tail"));
+  
   std::vector<size_t> permIndex2(n);
   for (size_t i = 0; i < permIndex2.size(); i++) {
     permIndex2[i] = i;
@@ -157,5 +268,21 @@ init_unit_test_suite( int argc, char* argv[] )
   
   decoder.scheduling(fec::Parallel);
   framework::master_test_suite().add(test_turbo(encoder, decoder, {}, 0.0, "3 var length constituents + Parallel"));
+  
+  auto lteEncoder = fec::Turbo::EncoderOptions(fec::Trellis({4}, {{015}}, {013}), {{}, fec::Turbo::Lte3Gpp::interleaver(n)});
+  auto lteCodec = fec::Turbo(lteEncoder, fec::Turbo::DecoderOptions());
+  test_suite* ts = BOOST_TEST_SUITE("lte");
+  ts->add( BOOST_TEST_CASE(std::bind(&test_turbo_lte3gpp_interleaver, 40, 3, 10 )));
+  ts->add( BOOST_TEST_CASE(std::bind(&test_turbo_lte3gpp_interleaver, 6144, 263, 480 )));
+  ts->add( BOOST_TEST_CASE(std::bind(&test_turbo_lte3gpp_rateMatching, lteCodec )));
+  ts->add( BOOST_TEST_CASE(std::bind(&test_turbo_lte3gpp_harq, lteCodec, 0.0, 1 )));
+  ts->add( BOOST_TEST_CASE(std::bind(&test_turbo_lte3gpp_harq, lteCodec, 0.0, 3 )));
+  framework::master_test_suite().add(ts);
+  
+  lteEncoder.termination(fec::Trellis::Tail);
+  framework::master_test_suite().add(test_turbo(lteEncoder, fec::Turbo::DecoderOptions().radix(4), {}, 0.0, "lte + radix 4"));
+  
+  framework::master_test_suite().add(BOOST_TEST_CASE(std::bind(&test_permutation_loadVersion0, 100)));
+  framework::master_test_suite().add(BOOST_TEST_CASE(std::bind(&test_permutation_loadVersion0, 70000)));
   return 0;
-}
\ No newline at end of file
+}
@@ -19,16 +19,29 @@
  along with FeCl.  If not, see <http://www.gnu.org/licenses/>.
  ******************************************************************************/
 
+#include <complex>
 #include <vector>
 #include <random>
 #include <memory>
 #include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#if defined(__linux__)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "Serialization.h"
 #include "Codec.h"
 #include "Convolutional.h"
 #include "Turbo.h"
 #include "Ldpc.h"
+#include "Demapper.h"
+#include "FileDecoder.h"
+#include "MemoryPool.h"
+#include "detail/Arena.h"
+#include "detail/Numa.h"
 
 template <typename T>
 std::ostream& operator<<(std::ostream& os, const std::vector<T>& a)
@@ -110,6 +123,28 @@ void test_saveLoad(const fec::Codec& code) {
   auto recover = fec::detail::load<fec::Codec>(&archive[0], archive.size(), derived);
 }
 
+void test_saveLoad_decode(const fec::Codec& code, double snr)
+{
+  fec::detail::DerivedTypeHolder<fec::Convolutional, fec::Turbo, fec::Ldpc> derived;
+  std::vector<char> archive(archiveSize(&code, derived));
+  save(&code, &archive[0], archive.size(), derived);
+  auto recover = fec::detail::load<fec::Codec>(&archive[0], archive.size(), derived);
+  
+  std::minstd_rand0 randomGenerator;
+  std::vector<fec::BitField<size_t>> msg(code.msgSize());
+  for (size_t i = 0; i < msg.size(); ++i) {
+    msg[i] = randomGenerator() % 2;
+  }
+  std::vector<double> parityIn = distort(code.encode(msg), snr);
+  auto msgOut = code.decode(parityIn);
+  auto recoverOut = recover->decode(parityIn);
+  
+  BOOST_REQUIRE(recoverOut.size() == msgOut.size());
+  for (size_t i = 0; i < msgOut.size(); ++i) {
+    BOOST_REQUIRE(msgOut[i] == recoverOut[i]);
+  }
+}
+
 void test_decode(const fec::Codec& code, double snr, size_t n = 1)
 {
   std::vector<fec::BitField<size_t>> msg(code.msgSize()*n, 1);
@@ -126,6 +161,257 @@ void test_decode(const fec::Codec& code, double snr, size_t n = 1)
   }
 }
 
+void test_decode_batchStatistics(const fec::Codec& code, double snr, size_t n)
+{
+  std::vector<fec::BitField<size_t>> msg(code.msgSize()*n, 1);
+  std::vector<fec::BitField<size_t>> parity = code.encode(msg);
+  
+  std::vector<double> parityIn = distort(parity, snr);
+  auto msgOut = code.decode(parityIn);
+  
+  auto statistics = code.getBatchStatistics();
+  BOOST_CHECK(statistics.blockCount == n);
+  BOOST_CHECK(statistics.workerCount >= 1 && statistics.workerCount <= n);
+  BOOST_CHECK(statistics.chunkCount >= statistics.workerCount || statistics.chunkCount == n);
+  BOOST_CHECK(statistics.tail >= 0.0 && statistics.tail <= statistics.duration);
+  for (size_t i = 0; i < msg.size(); ++i) {
+    BOOST_REQUIRE(msg[i] == msgOut[i]);
+  }
+}
+
+void test_decode_budget(const fec::Codec& code, double snr, size_t n)
+{
+  std::vector<fec::BitField<size_t>> msg(code.msgSize()*n, 1);
+  std::vector<fec::BitField<size_t>> parity = code.encode(msg);
+  
+  std::vector<double> parityIn = distort(parity, snr);
+  std::vector<fec::BitField<size_t>> msgOut;
+  std::vector<fec::BitField<size_t>> converged;
+  code.decode(parityIn, msgOut, converged, 1.0e3);
+  
+  BOOST_REQUIRE(msgOut.size() == msg.size());
+  BOOST_REQUIRE(converged.size() == n);
+  for (size_t i = 0; i < n; ++i) {
+    BOOST_REQUIRE(converged[i] == 1);
+  }
+  for (size_t i = 0; i < msg.size(); ++i) {
+    BOOST_REQUIRE(msg[i] == msgOut[i]);
+  }
+  
+  code.decode(parityIn, msgOut, converged, 0.0);
+  BOOST_REQUIRE(msgOut.size() == msg.size());
+  BOOST_REQUIRE(converged.size() == n);
+  
+  try {
+    code.decode(parityIn, msgOut, converged, -1.0);
+  } catch (std::exception& e) {
+    return;
+  }
+  BOOST_ERROR("Exception not thrown");
+}
+
+void test_decode_infiniteBudget(const fec::Codec& code, double snr, size_t n)
+{
+  std::minstd_rand0 randomGenerator;
+  std::vector<fec::BitField<size_t>> msg(code.msgSize()*n);
+  for (size_t i = 0; i < msg.size(); ++i) {
+    msg[i] = randomGenerator() % 2;
+  }
+  std::vector<double> parityIn = distort(code.encode(msg), snr);
+  
+  auto msgOut = code.decode(parityIn);
+  std::vector<fec::BitField<size_t>> timedMsgOut;
+  std::vector<fec::BitField<size_t>> converged;
+  code.decode(parityIn, timedMsgOut, converged, std::numeric_limits<double>::infinity());
+  
+  BOOST_REQUIRE(timedMsgOut.size() == msgOut.size());
+  BOOST_REQUIRE(converged.size() == n);
+  for (size_t i = 0; i < msgOut.size(); ++i) {
+    BOOST_REQUIRE(timedMsgOut[i] == msgOut[i]);
+  }
+}
+
+template <class Code>
+void test_decode_memoryPool(Code code, double snr, size_t n)
+{
+  std::vector<fec::BitField<size_t>> msg(code.msgSize()*n, 1);
+  std::vector<double> parityIn = distort(code.encode(msg), snr);
+  std::vector<double> msgOut;
+  code.soDecode(fec::Codec::Input<>().parity(parityIn), fec::Codec::Output<>().msg(msgOut));
+  
+  auto pool = std::make_shared<fec::MemoryPool>(fec::MemoryPool::Options().arenaSize(size_t(1) << 20).hugePages(true).lock(true));
+  code.setMemoryPool(pool);
+  for (size_t k = 0; k < 2; ++k) {
+    std::vector<double> msgPool;
+    code.soDecode(fec::Codec::Input<>().parity(parityIn), fec::Codec::Output<>().msg(msgPool));
+    BOOST_REQUIRE(msgPool.size() == msgOut.size());
+    for (size_t i = 0; i < msgOut.size(); ++i) {
+      BOOST_REQUIRE(msgPool[i] == msgOut[i]);
+    }
+    auto msgDecoded = code.decode(parityIn);
+    for (size_t i = 0; i < msg.size(); ++i) {
+      BOOST_REQUIRE(msg[i] == msgDecoded[i]);
+    }
+  }
+  BOOST_REQUIRE(pool->arenaCount() >= 1);
+  
+  fec::detail::Arena arena(1024);
+  {
+    fec::detail::Arena::Scope scope(&arena);
+    fec::detail::AlignedVector<double> inArena(3);
+    fec::detail::AlignedVector<double> onHeap(1024);
+    BOOST_REQUIRE(arena.owns(inArena.data()));
+    BOOST_REQUIRE(!arena.owns(onHeap.data()));
+    BOOST_REQUIRE(reinterpret_cast<uintptr_t>(inArena.data()) % fec::detail::Arena::alignment == 0);
+    BOOST_REQUIRE(reinterpret_cast<uintptr_t>(onHeap.data()) % fec::detail::Arena::alignment == 0);
+  }
+  BOOST_REQUIRE(arena.used() == 0);
+}
+
+template <class Code>
+void test_decode_numaAware(Code code, double snr, size_t n)
+{
+  std::minstd_rand0 randomGenerator;
+  std::vector<fec::BitField<size_t>> msg(code.msgSize()*n);
+  for (size_t i = 0; i < msg.size(); ++i) {
+    msg[i] = randomGenerator() % 2;
+  }
+  std::vector<double> parityIn = distort(code.encode(msg), snr);
+  auto msgOut = code.decode(parityIn);
+  
+  code.setNumaAware(true);
+  code.setWorkGroupSize(4);
+  auto numaMsgOut = code.decode(parityIn);
+  
+  BOOST_REQUIRE(numaMsgOut.size() == msgOut.size());
+  for (size_t i = 0; i < msgOut.size(); ++i) {
+    BOOST_REQUIRE(numaMsgOut[i] == msgOut[i]);
+  }
+}
+
+void test_numaTopology()
+{
+#if defined(__linux__)
+  const std::string root = "test_numaTopology";
+  mkdir(root.c_str(), 0755);
+  for (size_t node = 0; node < 3; ++node) {
+    mkdir((root + "/node" + std::to_string(node)).c_str(), 0755);
+  }
+  std::ofstream(root + "/online") << "0-2" << std::endl;
+  std::ofstream(root + "/node0/cpulist") << "0-3" << std::endl;
+  std::ofstream(root + "/node1/cpulist") << std::endl;
+  std::ofstream(root + "/node2/cpulist") << "4-5,8" << std::endl;
+  
+  fec::detail::Numa::Topology topology(root);
+  
+  for (size_t node = 0; node < 3; ++node) {
+    std::remove((root + "/node" + std::to_string(node) + "/cpulist").c_str());
+    rmdir((root + "/node" + std::to_string(node)).c_str());
+  }
+  std::remove((root + "/online").c_str());
+  rmdir(root.c_str());
+  
+  BOOST_REQUIRE(topology.nodeCount() == 2);
+  BOOST_REQUIRE(topology.id(0) == 0);
+  BOOST_REQUIRE(topology.id(1) == 2);
+  BOOST_REQUIRE(topology.cpus(0) == std::vector<size_t>({0, 1, 2, 3}));
+  BOOST_REQUIRE(topology.cpus(1) == std::vector<size_t>({4, 5, 8}));
+#endif
+  
+  fec::detail::Numa::Topology missing("test_numaTopology_missing");
+  BOOST_REQUIRE(missing.nodeCount() == 1);
+  BOOST_REQUIRE(missing.id(0) == 0);
+}
+
+void test_fileDecoder(const fec::Codec& code, double snr, size_t n)
+{
+  std::vector<fec::BitField<size_t>> msg(code.msgSize()*n);
+  std::minstd_rand0 randomGenerator;
+  for (size_t i = 0; i < msg.size(); ++i) {
+    msg[i] = randomGenerator() & 1;
+  }
+  std::vector<double> parityIn = distort(code.encode(msg), snr);
+  std::vector<float> llr(parityIn.begin(), parityIn.end());
+  {
+    std::ofstream file("test_fileDecoder.llr", std::ios::binary);
+    file.write(reinterpret_cast<const char*>(llr.data()), llr.size() * sizeof(float));
+  }
+  
+  auto options = fec::FileDecoder::Options().format(fec::FileDecoder::Float).chunkSize(2);
+  size_t blockCount = fec::FileDecoder(code, options).decode("test_fileDecoder.llr", "test_fileDecoder.msg");
+  BOOST_REQUIRE(blockCount == n);
+  
+  std::ifstream file("test_fileDecoder.msg", std::ios::binary);
+  std::vector<char> packed((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  BOOST_REQUIRE(packed.size() == (msg.size() + 7) / 8);
+  for (size_t i = 0; i < msg.size(); ++i) {
+    BOOST_REQUIRE(msg[i] == ((packed[i / 8] >> (7 - i % 8)) & 1));
+  }
+  std::remove("test_fileDecoder.llr");
+  std::remove("test_fileDecoder.msg");
+}
+
+void test_decode_demapper(const fec::Codec& code, fec::Demapper::Modulation modulation, fec::DecoderAlgorithm algorithm, double snrdb, size_t n)
+{
+  fec::Demapper demapper(modulation, algorithm);
+  std::vector<size_t> sequence(code.paritySize());
+  for (size_t i = 0; i < sequence.size(); ++i) {
+    sequence[i] = sequence.size() - 1 - i;
+  }
+  fec::Permutation interleaver(sequence, code.paritySize());
+  
+  std::vector<fec::BitField<size_t>> msg(code.msgSize()*n);
+  for (size_t i = 0; i < msg.size(); ++i) {
+    msg[i] = (i * 5 / 3) % 2;
+  }
+  std::vector<fec::BitField<size_t>> parity = code.encode(msg);
+  std::vector<fec::BitField<size_t>> bits = interleaver.permute(parity);
+  bits.resize((bits.size() + demapper.bitCount() - 1) / demapper.bitCount() * demapper.bitCount(), 0);
+  std::vector<std::complex<float>> symbols;
+  demapper.map(bits, symbols);
+  
+  double noiseVariance = pow(10.0, -snrdb/10.0);
+  std::minstd_rand0 randomGenerator;
+  randomGenerator.seed(0);
+  std::normal_distribution<float> normalDistribution(0.0, float(sqrt(noiseVariance/2.0)));
+  for (auto & symbol : symbols) {
+    symbol += std::complex<float>(normalDistribution(randomGenerator), normalDistribution(randomGenerator));
+  }
+  
+  std::vector<double> llr;
+  demapper.demap(symbols, {float(noiseVariance)}, llr);
+  BOOST_REQUIRE(llr.size() == bits.size());
+  
+  if (parity.size() % demapper.bitCount() == 0) {
+    std::vector<double> parityIn;
+    demapper.demap(symbols, std::vector<float>(symbols.size(), float(noiseVariance)), interleaver, parityIn);
+    auto expected = interleaver.dePermute(std::vector<double>(llr.begin(), llr.begin() + parity.size()));
+    BOOST_REQUIRE(parityIn.size() == parity.size());
+    for (size_t i = 0; i < parityIn.size(); ++i) {
+      BOOST_REQUIRE(parityIn[i] == expected[i]);
+    }
+  }
+  
+  auto msgOut = code.decode(interleaver.dePermute(std::vector<double>(llr.begin(), llr.begin() + parity.size())));
+  BOOST_REQUIRE(msgOut.size() == msg.size());
+  for (size_t i = 0; i < msg.size(); ++i) {
+    BOOST_REQUIRE(msg[i] == msgOut[i]);
+  }
+}
+
+void test_demapper_bpsk(fec::DecoderAlgorithm algorithm)
+{
+  fec::Demapper demapper(fec::Demapper::Bpsk, algorithm);
+  std::vector<std::complex<float>> symbols = {{0.5f, 0.0f}, {-1.25f, 0.5f}, {0.0f, 1.0f}};
+  std::vector<float> noiseVariance = {0.5f, 2.0f, 1.0f};
+  std::vector<double> llr;
+  demapper.demap(symbols, noiseVariance, llr);
+  BOOST_REQUIRE(llr.size() == symbols.size());
+  for (size_t i = 0; i < symbols.size(); ++i) {
+    BOOST_CHECK_CLOSE(llr[i] + 1.0, 4.0 * symbols[i].real() / noiseVariance[i] + 1.0, 1e-6);
+  }
+}
+
 void test_decode_puncture(const fec::Codec& codec, const fec::Permutation& perm, const fec::Codec& puncturedCodec, double snr, size_t n)
 {
   std::vector<fec::BitField<size_t>> msg(puncturedCodec.msgSize()*n, 1);
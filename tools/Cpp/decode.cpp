@@ -0,0 +1,102 @@
+/*******************************************************************************
+ This file is part of FeCl.
+ 
+ Copyright (c) 2015, Etienne Pierre-Doray, INRS
+ Copyright (c) 2015, Leszek Szczecinski, INRS
+ All rights reserved.
+ 
+ FeCl is free software: you can redistribute it and/or modify
+ it under the terms of the Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ FeCl is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the Lesser General Public License
+ along with FeCl.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+#include "Serialization.h"
+#include "Convolutional.h"
+#include "Turbo.h"
+#include "Ldpc.h"
+#include "FileDecoder.h"
+
+/**
+ *  Decodes a file of L-values with a serialized codec.
+ *  The codec file is a binary archive of the codec, as saved by fec::detail::save.
+ */
+
+void usage(const char* name)
+{
+  std::cerr << "usage: " << name << " codec llr msg [--format double|float|int8] [--scale factor] [--chunk blocks] [--threads count]" << std::endl;
+}
+
+int main(int argc, const char * argv[]) {
+  if (argc < 4) {
+    usage(argv[0]);
+    return 1;
+  }
+  
+  auto options = fec::FileDecoder::Options();
+  int threads = std::thread::hardware_concurrency();
+  for (int i = 4; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 == argc) {
+      usage(argv[0]);
+      return 1;
+    }
+    std::string value = argv[++i];
+    if (arg == "--format" && value == "double") {
+      options.format(fec::FileDecoder::Double);
+    } else if (arg == "--format" && value == "float") {
+      options.format(fec::FileDecoder::Float);
+    } else if (arg == "--format" && value == "int8") {
+      options.format(fec::FileDecoder::Int8);
+    } else if (arg == "--scale") {
+      options.scale(std::stod(value));
+    } else if (arg == "--chunk") {
+      options.chunkSize(std::stoul(value));
+    } else if (arg == "--threads") {
+      threads = std::stoi(value);
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  
+  try {
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file) {
+      throw std::invalid_argument("Invalid codec file");
+    }
+    std::vector<char> archive((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    fec::detail::DerivedTypeHolder<fec::Convolutional, fec::Turbo, fec::Ldpc> derived;
+    auto codec = fec::detail::load<fec::Codec>(archive.data(), archive.size(), derived);
+    if (threads > 0) {
+      codec->setWorkGroupSize(threads);
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    size_t blockCount = fec::FileDecoder(*codec, options).decode(argv[2], argv[3]);
+    double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    std::cout << blockCount << " blocks decoded in " << duration << " s, "
+              << blockCount * codec->msgSize() / duration / 1e6 << " Mbit/s" << std::endl;
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  
+  return 0;
+}